@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vm.h>
+
+#define GC_BENCH_ROUNDS 3
+
+/*
+  Allocation-heavy: a large live list the collector must trace every cycle,
+  and a loop that allocates short-lived nodes, closures and strings while
+  swapping fresh nodes into the live list (so incremental mode exercises
+  the write barrier too).
+*/
+static const char *source =
+    "class Node { init(value, next) { this.value = value; this.next = next; "
+    "} }\n"
+    "fun capture(x) { fun get() { return x; } return get; }\n"
+    "var live;\n"
+    "for (var i = 0; i < 200000; i = i + 1) live = Node(i, live);\n"
+    "var garbage;\n"
+    "var chain = 0;\n"
+    "for (var i = 0; i < 2000000; i = i + 1) {\n"
+    "  garbage = Node(capture(i), garbage);\n"
+    "  chain = chain + 1;\n"
+    "  if (chain == 100) { chain = 0; garbage = \"g\" + \"c\"; }\n"
+    "  live.next = Node(i, live.next.next);\n"
+    "}\n"
+    "var sum = 0;\n"
+    "for (var node = live; node != nil; node = node.next) {\n"
+    "  sum = sum + node.value;\n"
+    "}\n"
+    "print sum;\n";
+
+static const struct {
+  const char *name;
+  gc_mode_t mode;
+} modes[] = {
+    {"stop-the-world", GC_MODE_STOP_THE_WORLD},
+    {"incremental", GC_MODE_INCREMENTAL},
+};
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+typedef struct result_t {
+  double elapsed;
+  size_t cycles;
+  gc_pauses_t pauses;
+} result_t;
+
+// Runs the workload in a fresh vm, returning its timings and output.
+static result_t run(gc_mode_t mode, char **out) {
+  size_t length;
+  vm_t *vm = vm_new();
+  vm->gc.mode = mode;
+  vm->out = open_memstream(out, &length);
+  scanner_t scanner;
+  scanner_init(&scanner, source, strlen(source));
+  double start = now();
+  interpret_result_t result = vm_interpret(vm, &scanner);
+  result_t timings = {.elapsed = now() - start,
+                      .cycles = vm->gc.collections,
+                      .pauses = vm->gc.pauses};
+  fclose(vm->out);
+  vm_free(vm);
+  if (result != INTERPRET_OK) {
+    fprintf(stderr, "workload failed\n");
+    exit(1);
+  }
+  return timings;
+}
+
+int main() {
+  for (size_t i = 0; i < sizeof modes / sizeof modes[0]; i++) {
+    result_t best;
+    char *out = NULL;
+    for (int round = 0; round < GC_BENCH_ROUNDS; round++) {
+      free(out);
+      result_t result = run(modes[i].mode, &out);
+      if (round == 0 || result.elapsed < best.elapsed) {
+        best = result;
+      }
+    }
+    out[strcspn(out, "\n")] = '\0';
+    printf("%-14s %10.2f ms, %zu cycles, max pause %.3f ms  => %s\n  ",
+           modes[i].name, best.elapsed * 1e3, best.cycles,
+           best.pauses.max * 1e3, out);
+    gc_print_pauses(stdout, &best.pauses);
+    free(out);
+  }
+  return 0;
+}
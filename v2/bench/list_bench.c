@@ -0,0 +1,91 @@
+#include <doubly_linked_list.h>
+#include <stdio.h>
+#include <time.h>
+#include <unrolled_list.h>
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char *name, size_t n, double seconds) {
+  printf("%-12s %12zu %10.2f ms %8.2f ns/element\n", name, n, seconds * 1e3,
+         seconds * 1e9 / n);
+}
+
+static void bench_doubly_linked_list(size_t n) {
+  doubly_linked_list_t *list = doubly_linked_list_new();
+
+  double start = now();
+  for (size_t i = 0; i < n; i++) {
+    doubly_linked_node_t *node = malloc(sizeof(doubly_linked_node_t));
+    node->data = (void *)i;
+    doubly_linked_list_insert_end(list, node);
+  }
+  double insert = now() - start;
+
+  start = now();
+  size_t sum = 0;
+  for (doubly_linked_node_t *node = list->head; node; node = node->next) {
+    sum += (size_t)node->data;
+  }
+  double traverse = now() - start;
+
+  start = now();
+  doubly_linked_node_t *node;
+  while ((node = doubly_linked_list_pop_front(list)) != NULL) {
+    free(node);
+  }
+  double remove = now() - start;
+
+  printf("doubly_linked_list (checksum %zu)\n", sum);
+  report("  insert", n, insert);
+  report("  traverse", n, traverse);
+  report("  remove", n, remove);
+  free(list);
+}
+
+static void bench_unrolled_list(size_t n) {
+  unrolled_list_t *list = unrolled_list_new();
+
+  double start = now();
+  for (size_t i = 0; i < n; i++) {
+    unrolled_list_insert_end(list, (void *)i);
+  }
+  double insert = now() - start;
+
+  start = now();
+  size_t sum = 0;
+  for (unrolled_list_node_t *node = list->head; node; node = node->next) {
+    for (size_t i = 0; i < node->count; i++) {
+      sum += (size_t)node->data[i];
+    }
+  }
+  double traverse = now() - start;
+
+  start = now();
+  unrolled_list_iterator_t it = unrolled_list_begin(list);
+  while (unrolled_list_iterator_valid(it)) {
+    unrolled_list_remove(list, &it);
+  }
+  double remove = now() - start;
+
+  printf("unrolled_list (checksum %zu)\n", sum);
+  report("  insert", n, insert);
+  report("  traverse", n, traverse);
+  report("  remove", n, remove);
+  unrolled_list_free(list);
+}
+
+int main(int argc, char **argv) {
+  size_t defaults[] = {1000, 1000000, 100000000};
+  int count = argc > 1 ? argc - 1 : 3;
+  for (int i = 0; i < count; i++) {
+    size_t n = argc > 1 ? strtoull(argv[i + 1], NULL, 10) : defaults[i];
+    printf("\n%zu elements\n", n);
+    bench_doubly_linked_list(n);
+    bench_unrolled_list(n);
+  }
+  return 0;
+}
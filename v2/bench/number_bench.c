@@ -0,0 +1,82 @@
+#include <string/string.h>
+#include <time.h>
+
+#define LITERAL_COUNT 1000000
+#define LITERAL_SIZE 32
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t next(uint64_t *state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return *state;
+}
+
+// A mix of the literal shapes Lox programs contain: small integers, short
+// decimals and full-precision doubles.
+static void literal(char *buffer, uint64_t *state) {
+  uint64_t r = next(state);
+  switch (r % 3) {
+  case 0:
+    snprintf(buffer, LITERAL_SIZE, "%llu",
+             (unsigned long long)(r >> 8) % 100000);
+    break;
+  case 1:
+    snprintf(buffer, LITERAL_SIZE, "%llu.%llu",
+             (unsigned long long)(r >> 8) % 10000,
+             (unsigned long long)next(state) % 1000);
+    break;
+  default:
+    snprintf(buffer, LITERAL_SIZE, "%.17g",
+             (double)(next(state) >> 11) / (double)(1ull << 53) * 1e6);
+  }
+}
+
+int main() {
+  char *literals = malloc((size_t)LITERAL_COUNT * LITERAL_SIZE);
+  size_t *lengths = malloc(LITERAL_COUNT * sizeof(size_t));
+  uint64_t state = 88172645463325252ull;
+  for (size_t i = 0; i < LITERAL_COUNT; i++) {
+    literal(literals + i * LITERAL_SIZE, &state);
+    lengths[i] = strlen(literals + i * LITERAL_SIZE);
+  }
+
+  double sum = 0;
+  double start = now();
+  for (size_t i = 0; i < LITERAL_COUNT; i++) {
+    sum += strtod(literals + i * LITERAL_SIZE, NULL);
+  }
+  double strtodTime = now() - start;
+
+  double fastSum = 0;
+  size_t mismatches = 0;
+  start = now();
+  for (size_t i = 0; i < LITERAL_COUNT; i++) {
+    fastSum +=
+        stringParseDecimal(literals + i * LITERAL_SIZE, lengths[i]).value;
+  }
+  double fastTime = now() - start;
+
+  for (size_t i = 0; i < LITERAL_COUNT; i++) {
+    const char *str = literals + i * LITERAL_SIZE;
+    mismatches +=
+        strtod(str, NULL) != stringParseDecimal(str, lengths[i]).value;
+  }
+
+  printf("%d literals\n", LITERAL_COUNT);
+  printf("strtod             %8.2f ms %8.2f ns/literal\n", strtodTime * 1e3,
+         strtodTime * 1e9 / LITERAL_COUNT);
+  printf("stringParseDecimal %8.2f ms %8.2f ns/literal\n", fastTime * 1e3,
+         fastTime * 1e9 / LITERAL_COUNT);
+  printf("speedup %.2fx, %zu mismatches, checksum %s\n", strtodTime / fastTime,
+         mismatches, sum == fastSum ? "equal" : "differs");
+
+  free(literals);
+  free(lengths);
+  return 0;
+}
@@ -0,0 +1,115 @@
+#include <doubly_linked_list.h>
+#include <mpsc_queue.h>
+#include <stdio.h>
+#include <time.h>
+
+#define ITEMS 4000000
+
+typedef struct {
+  pthread_mutex_t lock;
+  pthread_cond_t ready;
+  doubly_linked_list_t *list;
+} locked_list_t;
+
+typedef struct {
+  mpsc_queue_t *queue;
+  locked_list_t *locked;
+  doubly_linked_node_t *nodes;
+  size_t count;
+} producer_t;
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char *name, int producers, double seconds) {
+  printf("%-18s %2d producers %10.2f ms %8.2f Mitems/s\n", name, producers,
+         seconds * 1e3, ITEMS / seconds / 1e6);
+}
+
+static void *produce_mpsc(void *arg) {
+  producer_t *producer = arg;
+  for (size_t i = 0; i < producer->count; i++) {
+    mpsc_queue_push(producer->queue, &producer->nodes[i]);
+  }
+  return NULL;
+}
+
+static void *produce_locked(void *arg) {
+  producer_t *producer = arg;
+  locked_list_t *locked = producer->locked;
+  for (size_t i = 0; i < producer->count; i++) {
+    pthread_mutex_lock(&locked->lock);
+    doubly_linked_list_insert_end(locked->list, &producer->nodes[i]);
+    pthread_cond_signal(&locked->ready);
+    pthread_mutex_unlock(&locked->lock);
+  }
+  return NULL;
+}
+
+static double run(int producer_count, doubly_linked_node_t *nodes,
+                  void *(*produce)(void *), mpsc_queue_t *queue,
+                  locked_list_t *locked) {
+  producer_t producers[producer_count];
+  pthread_t threads[producer_count];
+  size_t per_producer = ITEMS / producer_count;
+
+  double start = now();
+  for (int p = 0; p < producer_count; p++) {
+    producers[p].queue = queue;
+    producers[p].locked = locked;
+    producers[p].nodes = &nodes[p * per_producer];
+    producers[p].count = per_producer;
+    pthread_create(&threads[p], NULL, produce, &producers[p]);
+  }
+
+  size_t total = per_producer * producer_count;
+  for (size_t received = 0; received < total; received++) {
+    if (queue != NULL) {
+      mpsc_queue_wait(queue);
+    } else {
+      pthread_mutex_lock(&locked->lock);
+      while (locked->list->size == 0) {
+        pthread_cond_wait(&locked->ready, &locked->lock);
+      }
+      doubly_linked_list_pop_front(locked->list);
+      pthread_mutex_unlock(&locked->lock);
+    }
+  }
+  double elapsed = now() - start;
+
+  for (int p = 0; p < producer_count; p++) {
+    pthread_join(threads[p], NULL);
+  }
+  return elapsed;
+}
+
+int main(int argc, char **argv) {
+  int defaults[] = {1, 2, 4, 8};
+  int count = argc > 1 ? argc - 1 : 4;
+  doubly_linked_node_t *nodes = malloc(sizeof(doubly_linked_node_t) * ITEMS);
+
+  for (int i = 0; i < count; i++) {
+    int producers = argc > 1 ? atoi(argv[i + 1]) : defaults[i];
+
+    mpsc_queue_t *queue = mpsc_queue_new();
+    report("mpsc_queue", producers,
+           run(producers, nodes, produce_mpsc, queue, NULL));
+    mpsc_queue_free(queue);
+
+    locked_list_t locked;
+    pthread_mutex_init(&locked.lock, NULL);
+    pthread_cond_init(&locked.ready, NULL);
+    locked.list = doubly_linked_list_new();
+    report("mutex + list", producers,
+           run(producers, nodes, produce_locked, NULL, &locked));
+    doubly_linked_list_destroy(locked.list, NULL);
+    pthread_cond_destroy(&locked.ready);
+    pthread_mutex_destroy(&locked.lock);
+  }
+
+  free(nodes);
+  return 0;
+}
@@ -0,0 +1,132 @@
+#include <parallel_scanner.h>
+#include <scanner.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define ROUNDS 5
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// One unit of the generated corpus; %1$d keeps the names distinct.
+static const char *corpus_unit =
+    "// Compute the nth fibonacci number the slow way.\n"
+    "fun fib%1$d(n) {\n"
+    "  if (n < 2) return n;\n"
+    "  return fib%1$d(n - 1) + fib%1$d(n - 2);\n"
+    "}\n"
+    "\n"
+    "/*\n"
+    "  A counter that starts wherever it is told to and counts in steps of\n"
+    "  one and a half. /* Nested comments are allowed. */\n"
+    "*/\n"
+    "class Counter%1$d < Base {\n"
+    "  init(start) {\n"
+    "    this.count = start;\n"
+    "    this.label = \"counter number %1$d, with a reasonably long label\";\n"
+    "  }\n"
+    "\n"
+    "  increment() {\n"
+    "    this.count = this.count + 1.5;\n"
+    "    return this;\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "var total%1$d = 0;\n"
+    "for (var index = 0; index <= 100; index = index + 1) {\n"
+    "    total%1$d = total%1$d + fib%1$d(index) * 2; // accumulate\n"
+    "}\n"
+    "print total%1$d != nil and !false;\n";
+
+static char *generate_corpus(size_t target, size_t *length) {
+  char *source = malloc(target + 4096);
+  size_t used = 0;
+  for (int unit = 0; used < target; unit++) {
+    used += (size_t)sprintf(source + used, corpus_unit, unit);
+  }
+  *length = used;
+  return source;
+}
+
+static int same_tokens(token_stream_t *a, token_stream_t *b) {
+  if (a->count != b->count) {
+    return 0;
+  }
+  for (size_t i = 0; i < a->count; i++) {
+    token_t x = a->tokens[i];
+    token_t y = b->tokens[i];
+    if (x.type != y.type || x.line != y.line || x.start != y.start ||
+        x.length != y.length) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+// Whole-stream scans on 1 to max_threads threads, checked against 1 thread.
+static void bench_scaling(const char *source, size_t length, int max_threads) {
+  token_stream_t *reference = parallel_scanner_scan(source, length, 1);
+  double single = 0;
+  for (int threads = 1; threads <= max_threads; threads++) {
+    double best = 0;
+    int same = 1;
+    for (int round = 0; round < ROUNDS; round++) {
+      double start = now();
+      token_stream_t *stream = parallel_scanner_scan(source, length, threads);
+      double elapsed = now() - start;
+      same &= same_tokens(stream, reference);
+      token_stream_free(stream);
+      if (best == 0 || elapsed < best) {
+        best = elapsed;
+      }
+    }
+    if (threads == 1) {
+      single = best;
+    }
+    printf("%2d threads %10.2f ms %8.1f MB/s %6.2fx%s\n", threads,
+           best * 1e3, length / best / (1 << 20), single / best,
+           same ? "" : "  MISMATCH");
+  }
+  token_stream_free(reference);
+}
+
+int main(int argc, char **argv) {
+  size_t megabytes = argc > 1 ? strtoull(argv[1], NULL, 10) : 64;
+  int max_threads = argc > 2 ? atoi(argv[2]) : 1;
+  size_t length;
+  char *source = generate_corpus(megabytes << 20, &length);
+
+  double best = 0;
+  size_t tokens = 0;
+  int line = 0;
+  for (int round = 0; round < ROUNDS; round++) {
+    scanner_t scanner;
+    scanner_init(&scanner, source, length);
+    tokens = 0;
+    double start = now();
+    token_t token;
+    do {
+      token = scanner_scan_token(&scanner);
+      tokens++;
+    } while (token.type != TOKEN_EOF);
+    double elapsed = now() - start;
+    line = token.line;
+    if (best == 0 || elapsed < best) {
+      best = elapsed;
+    }
+  }
+
+  printf("%zu bytes, %d lines, %zu tokens\n", length, line, tokens);
+  printf("scan %10.2f ms %8.1f MB/s %8.1f Mtokens/s\n", best * 1e3,
+         length / best / (1 << 20), tokens / best / 1e6);
+
+  printf("\nparallel_scanner_scan\n");
+  bench_scaling(source, length, max_threads);
+
+  free(source);
+  return 0;
+}
@@ -0,0 +1,54 @@
+#include <string/string.h>
+#include <time.h>
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+  size_t maxTokens = argc > 1 ? strtoull(argv[1], NULL, 10) : 10000000;
+
+  printf("%12s %12s %12s %12s %12s\n", "tokens", "split ms", "view ms",
+         "push ms", "ns/token");
+  for (size_t n = 1000; n <= maxTokens; n *= 10) {
+    char *line = malloc(n * 4 + 1);
+    for (size_t i = 0; i < n; i++) {
+      memcpy(line + i * 4, "tok ", 4);
+    }
+    line[n * 4] = '\0';
+    string_t *s = string(line);
+    free(line);
+
+    double start = now();
+    string_collection_t *tokens = stringSplit(s, " ");
+    double split = now() - start;
+
+    start = now();
+    string_split_iterator_t iterator = stringSplitView(s, " ");
+    string_view_t token;
+    size_t viewCount = 0;
+    while (stringSplitViewNext(&iterator, &token)) {
+      viewCount += token.length > 0;
+    }
+    double view = now() - start;
+
+    string_collection_t *pushed = stringCollection(0, NULL);
+    start = now();
+    for (size_t i = 0; i < n; i++) {
+      stringCollectionPush(pushed, tokens->arr[i]);
+    }
+    double push = now() - start;
+
+    printf("%12zu %12.2f %12.2f %12.2f %12.2f\n", viewCount, split * 1e3,
+           view * 1e3, push * 1e3, split * 1e9 / n);
+
+    pushed->size = 0;
+    stringCollectionFree(pushed);
+    stringCollectionFree(tokens);
+    stringFree(s);
+  }
+
+  return 0;
+}
@@ -0,0 +1,145 @@
+#include <object.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <table.h>
+#include <time.h>
+
+static const int loads[] = {50, 75, 90};
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t next(uint64_t *state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return *state;
+}
+
+// The FNV-1a hash object_copy_string caches on every string.
+static uint32_t hash_chars(const char *chars, size_t length) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < length; i++) {
+    hash ^= (uint8_t)chars[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+// Identifier-like keys, built directly so no vm or intern set is involved.
+static obj_string_t **make_keys(const char *prefix, size_t n) {
+  obj_string_t **keys = malloc(n * sizeof(obj_string_t *));
+  for (size_t i = 0; i < n; i++) {
+    char chars[32];
+    size_t length = (size_t)snprintf(chars, sizeof chars, "%s%zu", prefix, i);
+    obj_string_t *key = malloc(sizeof(obj_string_t) + length + 1);
+    key->obj.type = OBJ_STRING;
+    key->length = length;
+    key->hash = hash_chars(chars, length);
+    memcpy(key->chars, chars, length + 1);
+    keys[i] = key;
+  }
+  return keys;
+}
+
+static void free_keys(obj_string_t **keys, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    free(keys[i]);
+  }
+  free(keys);
+}
+
+// A random probe order, so lookups don't walk the keys in insertion order.
+static size_t *shuffled(size_t n) {
+  size_t *order = malloc(n * sizeof(size_t));
+  for (size_t i = 0; i < n; i++) {
+    order[i] = i;
+  }
+  uint64_t state = 0x2545f4914f6cdd1d;
+  for (size_t i = n - 1; i > 0; i--) {
+    size_t j = next(&state) % (i + 1);
+    size_t swap = order[i];
+    order[i] = order[j];
+    order[j] = swap;
+  }
+  return order;
+}
+
+static void report(const char *name, size_t n, double seconds) {
+  printf("  %-10s %10.2f ms %8.2f ns/op\n", name, seconds * 1e3,
+         seconds * 1e9 / n);
+}
+
+static void bench_table(obj_string_t **keys, obj_string_t **missing,
+                        size_t *order, size_t n, int load) {
+  table_t table;
+  table_init(&table);
+  table.max_load = load;
+
+  double start = now();
+  for (size_t i = 0; i < n; i++) {
+    table_set(&table, keys[i], value_number((double)i));
+  }
+  double insert = now() - start;
+
+  size_t found = 0;
+  value_t value;
+  start = now();
+  for (size_t i = 0; i < n; i++) {
+    found += table_get(&table, keys[order[i]], &value);
+  }
+  double hit = now() - start;
+
+  start = now();
+  for (size_t i = 0; i < n; i++) {
+    found += table_get(&table, missing[order[i]], &value);
+  }
+  double miss = now() - start;
+
+  start = now();
+  for (size_t i = 0; i < n; i++) {
+    obj_string_t *key = keys[order[i]];
+    found += table_find_string(&table, key->chars, key->length, key->hash) ==
+             key;
+  }
+  double intern = now() - start;
+
+  start = now();
+  for (size_t i = 0; i < n; i++) {
+    found += table_delete(&table, keys[order[i]]);
+  }
+  double delete = now() - start;
+
+  printf("max load %d%%, capacity %zu, %s\n", load, table.capacity,
+         found == 3 * n ? "all found" : "LOOKUPS FAILED");
+  report("insert", n, insert);
+  report("hit", n, hit);
+  report("miss", n, miss);
+  report("intern", n, intern);
+  report("delete", n, delete);
+  table_free(&table);
+}
+
+int main(int argc, char **argv) {
+  size_t defaults[] = {1000, 100000, 1000000, 10000000};
+  int count = argc > 1 ? argc - 1 : 4;
+  for (int i = 0; i < count; i++) {
+    size_t n = argc > 1 ? strtoull(argv[i + 1], NULL, 10) : defaults[i];
+    obj_string_t **keys = make_keys("key", n);
+    obj_string_t **missing = make_keys("absent", n);
+    size_t *order = shuffled(n);
+    printf("\n%zu keys\n", n);
+    for (size_t j = 0; j < sizeof loads / sizeof loads[0]; j++) {
+      bench_table(keys, missing, order, n, loads[j]);
+    }
+    free_keys(keys, n);
+    free_keys(missing, n);
+    free(order);
+  }
+  return 0;
+}
@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vm.h>
+
+#define VM_BENCH_ROUNDS 3
+
+#ifdef VM_SWITCH_DISPATCH
+#define DISPATCH_NAME "switch"
+#else
+#define DISPATCH_NAME "computed goto"
+#endif
+
+#ifdef VALUE_TAGGED_UNION
+#define VALUE_NAME "tagged union"
+#else
+#define VALUE_NAME "nan-boxed"
+#endif
+
+#ifdef COMPILER_NO_PEEPHOLE
+#define PEEPHOLE_NAME "off"
+#else
+#define PEEPHOLE_NAME "on"
+#endif
+
+typedef struct program_t {
+  const char *name;
+  const char *source;
+  // How many units of work the program does, and what they are.
+  double work;
+  const char *unit;
+} program_t;
+
+static const program_t programs[] = {
+    {"fib",
+     "fun fib(n) { if (n < 2) return n; return fib(n - 2) + fib(n - 1); }\n"
+     "print fib(30);\n",
+     // fib(n) makes 2 * fib(n + 1) - 1 calls.
+     2 * 1346269 - 1, "calls"},
+    {"loop-sum",
+     "{\n"
+     "  var sum = 0;\n"
+     "  for (var i = 0; i < 10000000; i = i + 1) {\n"
+     "    sum = sum + i;\n"
+     "  }\n"
+     "  print sum;\n"
+     "}\n",
+     10000000, "iterations"},
+    {"string-concat",
+     "{\n"
+     "  var a = \"con\";\n"
+     "  var b = \"cat\";\n"
+     "  var s;\n"
+     "  for (var i = 0; i < 2000000; i = i + 1) {\n"
+     "    s = a + b;\n"
+     "    s = s + \"!\";\n"
+     "  }\n"
+     "  print s;\n"
+     "}\n",
+     4000000, "concats"},
+};
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Runs the program in a fresh vm, returning the time taken and its output.
+static double run(const program_t *program, char **out) {
+  size_t length;
+  vm_t *vm = vm_new();
+  vm->out = open_memstream(out, &length);
+  scanner_t scanner;
+  scanner_init(&scanner, program->source, strlen(program->source));
+  double start = now();
+  interpret_result_t result = vm_interpret(vm, &scanner);
+  double elapsed = now() - start;
+  fclose(vm->out);
+  vm_free(vm);
+  if (result != INTERPRET_OK) {
+    fprintf(stderr, "%s failed\n", program->name);
+    exit(1);
+  }
+  return elapsed;
+}
+
+int main() {
+  printf("dispatch %s, superinstructions %s, %s values (%zu bytes, %zu KiB "
+         "stack)\n",
+         DISPATCH_NAME, PEEPHOLE_NAME, VALUE_NAME, sizeof(value_t),
+         sizeof(value_t) * VM_STACK_MAX / 1024);
+  for (size_t i = 0; i < sizeof programs / sizeof programs[0]; i++) {
+    const program_t *program = &programs[i];
+    double best = 0;
+    char *out = NULL;
+    for (int round = 0; round < VM_BENCH_ROUNDS; round++) {
+      free(out);
+      double elapsed = run(program, &out);
+      if (round == 0 || elapsed < best) {
+        best = elapsed;
+      }
+    }
+    out[strcspn(out, "\n")] = '\0';
+    printf("%-14s %10.2f ms %8.2f M%s/s  => %s\n", program->name, best * 1e3,
+           program->work / best / 1e6, program->unit, out);
+    free(out);
+  }
+  return 0;
+}
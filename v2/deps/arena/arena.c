@@ -0,0 +1,117 @@
+/*
+  Copyright (c) 2022 William Cotton
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "arena.h"
+#include <string.h>
+
+#define ARENA_ALIGNMENT (sizeof(max_align_t))
+
+static size_t alignUp(size_t size) {
+  return (size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+}
+
+static arena_block_t *arenaBlock(size_t size) {
+  arena_block_t *block = malloc(sizeof(arena_block_t) + size);
+  block->next = NULL;
+  block->size = size;
+  block->used = 0;
+  return block;
+}
+
+arena_t *arena(size_t blockSize) {
+  arena_t *a = malloc(sizeof(arena_t));
+  a->blockSize = alignUp(blockSize ? blockSize : ARENA_DEFAULT_BLOCK_SIZE);
+  a->head = arenaBlock(a->blockSize);
+  a->current = a->head;
+  a->large = NULL;
+  return a;
+}
+
+void *arenaAlloc(arena_t *a, size_t size) {
+  size = alignUp(size ? size : 1);
+  if (size > a->blockSize) {
+    arena_block_t *block = arenaBlock(size);
+    block->used = size;
+    block->next = a->large;
+    a->large = block;
+    return block->data;
+  }
+  if (a->current->used + size > a->current->size) {
+    if (a->current->next == NULL) {
+      a->current->next = arenaBlock(a->blockSize);
+    }
+    a->current = a->current->next;
+    a->current->used = 0;
+  }
+  void *ptr = (char *)a->current->data + a->current->used;
+  a->current->used += size;
+  return ptr;
+}
+
+void *arenaRealloc(arena_t *a, void *ptr, size_t oldSize, size_t size) {
+  if (ptr != NULL && size <= oldSize) {
+    return ptr;
+  }
+  // Grow in place when ptr is the most recent allocation in the block.
+  arena_block_t *block = a->current;
+  char *end = (char *)block->data + block->used;
+  if (ptr != NULL && (char *)ptr + alignUp(oldSize) == end &&
+      (char *)ptr - (char *)block->data + alignUp(size) <= block->size) {
+    block->used = (char *)ptr - (char *)block->data + alignUp(size);
+    return ptr;
+  }
+  void *newPtr = arenaAlloc(a, size);
+  if (ptr != NULL) {
+    memcpy(newPtr, ptr, oldSize);
+  }
+  return newPtr;
+}
+
+char *arenaStrndup(arena_t *a, const char *str, size_t length) {
+  char *copy = arenaAlloc(a, length + 1);
+  memcpy(copy, str, length);
+  copy[length] = '\0';
+  return copy;
+}
+
+// Regular blocks are kept for reuse without being visited; each large
+// block is freed, so the walk is as long as the large list.
+void arenaReset(arena_t *a) {
+  while (a->large != NULL) {
+    arena_block_t *next = a->large->next;
+    free(a->large);
+    a->large = next;
+  }
+  a->current = a->head;
+  a->current->used = 0;
+}
+
+void arenaFree(arena_t *a) {
+  arenaReset(a);
+  arena_block_t *block = a->head;
+  while (block != NULL) {
+    arena_block_t *next = block->next;
+    free(block);
+    block = next;
+  }
+  free(a);
+}
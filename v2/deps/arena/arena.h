@@ -0,0 +1,60 @@
+/*
+  Copyright (c) 2022 William Cotton
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#define ARENA_DEFAULT_BLOCK_SIZE (64 * 1024)
+
+typedef struct arena_block_t {
+  struct arena_block_t *next;
+  size_t size;
+  size_t used;
+  max_align_t data[];
+} arena_block_t;
+
+/*
+  A region allocator: allocations are bump-pointer carves out of a chain of
+  blocks and are never freed individually. arenaReset rewinds to the first
+  block so the chain is reused by the next parse or request; only
+  allocations larger than the block size, which get blocks of their own,
+  are returned to the system on reset. Reset therefore costs O(number of
+  large blocks): constant when every allocation fits in a block.
+*/
+typedef struct arena_t {
+  size_t blockSize;
+  arena_block_t *head;
+  arena_block_t *current;
+  arena_block_t *large;
+} arena_t;
+
+arena_t *arena(size_t blockSize);
+void *arenaAlloc(arena_t *arena, size_t size);
+void *arenaRealloc(arena_t *arena, void *ptr, size_t oldSize, size_t size);
+char *arenaStrndup(arena_t *arena, const char *str, size_t length);
+void arenaReset(arena_t *arena);
+void arenaFree(arena_t *arena);
+
+#endif // ARENA_H
@@ -0,0 +1,234 @@
+/*
+  Copyright (c) 2022 William Cotton
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#include "ascii.h"
+
+#ifdef __SSE2__
+#include <immintrin.h>
+#include <pthread.h>
+#define ASCII_X86 1
+#endif
+
+static inline int isAsciiSpace(char c) {
+  return c == ' ' || (unsigned char)(c - '\t') <= '\r' - '\t';
+}
+
+void stringAsciiUpcaseScalar(char *str, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    if ((unsigned char)(str[i] - 'a') < 26) {
+      str[i] ^= 0x20;
+    }
+  }
+}
+
+void stringAsciiDowncaseScalar(char *str, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    if ((unsigned char)(str[i] - 'A') < 26) {
+      str[i] ^= 0x20;
+    }
+  }
+}
+
+size_t stringAsciiSpanSpaceScalar(const char *str, size_t length) {
+  size_t i = 0;
+  while (i < length && isAsciiSpace(str[i])) {
+    i++;
+  }
+  return i;
+}
+
+size_t stringAsciiTrimEndScalar(const char *str, size_t length) {
+  while (length > 0 && isAsciiSpace(str[length - 1])) {
+    length--;
+  }
+  return length;
+}
+
+#ifdef ASCII_X86
+
+/*
+  A byte is in [lo, lo + 25] when (byte - lo), as an unsigned byte, is at
+  most 25, i.e. when min(byte - lo, 25) == byte - lo. Flipping bit 5 of
+  those bytes swaps their case.
+*/
+static void flipCaseSse2(char *str, size_t length, char lo) {
+  const __m128i base = _mm_set1_epi8(lo);
+  const __m128i range = _mm_set1_epi8(25);
+  const __m128i flip = _mm_set1_epi8(0x20);
+  size_t i = 0;
+  for (; i + 16 <= length; i += 16) {
+    __m128i block = _mm_loadu_si128((const __m128i *)(str + i));
+    __m128i offset = _mm_sub_epi8(block, base);
+    __m128i inRange = _mm_cmpeq_epi8(_mm_min_epu8(offset, range), offset);
+    block = _mm_xor_si128(block, _mm_and_si128(inRange, flip));
+    _mm_storeu_si128((__m128i *)(str + i), block);
+  }
+  if (lo == 'a') {
+    stringAsciiUpcaseScalar(str + i, length - i);
+  } else {
+    stringAsciiDowncaseScalar(str + i, length - i);
+  }
+}
+
+// Bit i of the result is set when byte i of block is ASCII whitespace.
+static inline unsigned spaceMaskSse2(__m128i block) {
+  __m128i space = _mm_cmpeq_epi8(block, _mm_set1_epi8(' '));
+  __m128i offset = _mm_sub_epi8(block, _mm_set1_epi8('\t'));
+  __m128i control =
+      _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8('\r' - '\t')), offset);
+  return _mm_movemask_epi8(_mm_or_si128(space, control));
+}
+
+static size_t spanSpaceSse2(const char *str, size_t length) {
+  size_t i = 0;
+  for (; i + 16 <= length; i += 16) {
+    unsigned mask =
+        ~spaceMaskSse2(_mm_loadu_si128((const __m128i *)(str + i))) & 0xffff;
+    if (mask != 0) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+  return i + stringAsciiSpanSpaceScalar(str + i, length - i);
+}
+
+static size_t trimEndSse2(const char *str, size_t length) {
+  while (length >= 16) {
+    unsigned mask =
+        ~spaceMaskSse2(_mm_loadu_si128((const __m128i *)(str + length - 16))) &
+        0xffff;
+    if (mask != 0) {
+      return length - 16 + (31 - __builtin_clz(mask)) + 1;
+    }
+    length -= 16;
+  }
+  return stringAsciiTrimEndScalar(str, length);
+}
+
+__attribute__((target("avx2"))) static void flipCaseAvx2(char *str,
+                                                         size_t length,
+                                                         char lo) {
+  const __m256i base = _mm256_set1_epi8(lo);
+  const __m256i range = _mm256_set1_epi8(25);
+  const __m256i flip = _mm256_set1_epi8(0x20);
+  size_t i = 0;
+  for (; i + 32 <= length; i += 32) {
+    __m256i block = _mm256_loadu_si256((const __m256i *)(str + i));
+    __m256i offset = _mm256_sub_epi8(block, base);
+    __m256i inRange =
+        _mm256_cmpeq_epi8(_mm256_min_epu8(offset, range), offset);
+    block = _mm256_xor_si256(block, _mm256_and_si256(inRange, flip));
+    _mm256_storeu_si256((__m256i *)(str + i), block);
+  }
+  flipCaseSse2(str + i, length - i, lo);
+}
+
+__attribute__((target("avx2"))) static inline unsigned
+spaceMaskAvx2(__m256i block) {
+  __m256i space = _mm256_cmpeq_epi8(block, _mm256_set1_epi8(' '));
+  __m256i offset = _mm256_sub_epi8(block, _mm256_set1_epi8('\t'));
+  __m256i control = _mm256_cmpeq_epi8(
+      _mm256_min_epu8(offset, _mm256_set1_epi8('\r' - '\t')), offset);
+  return _mm256_movemask_epi8(_mm256_or_si256(space, control));
+}
+
+__attribute__((target("avx2"))) static size_t spanSpaceAvx2(const char *str,
+                                                            size_t length) {
+  size_t i = 0;
+  for (; i + 32 <= length; i += 32) {
+    unsigned mask =
+        ~spaceMaskAvx2(_mm256_loadu_si256((const __m256i *)(str + i)));
+    if (mask != 0) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+  return i + spanSpaceSse2(str + i, length - i);
+}
+
+__attribute__((target("avx2"))) static size_t trimEndAvx2(const char *str,
+                                                          size_t length) {
+  while (length >= 32) {
+    unsigned mask = ~spaceMaskAvx2(
+        _mm256_loadu_si256((const __m256i *)(str + length - 32)));
+    if (mask != 0) {
+      return length - 32 + (31 - __builtin_clz(mask)) + 1;
+    }
+    length -= 32;
+  }
+  return trimEndSse2(str, length);
+}
+
+// Resolved once so the kernels are safe to call from several threads.
+static int hasAvx2 = 0;
+static pthread_once_t hasAvx2Resolved = PTHREAD_ONCE_INIT;
+
+static void resolveAvx2(void) {
+  hasAvx2 = __builtin_cpu_supports("avx2") ? 1 : 0;
+}
+
+static int useAvx2(void) {
+  pthread_once(&hasAvx2Resolved, resolveAvx2);
+  return hasAvx2;
+}
+
+void stringAsciiUpcase(char *str, size_t length) {
+  if (useAvx2()) {
+    flipCaseAvx2(str, length, 'a');
+  } else {
+    flipCaseSse2(str, length, 'a');
+  }
+}
+
+void stringAsciiDowncase(char *str, size_t length) {
+  if (useAvx2()) {
+    flipCaseAvx2(str, length, 'A');
+  } else {
+    flipCaseSse2(str, length, 'A');
+  }
+}
+
+size_t stringAsciiSpanSpace(const char *str, size_t length) {
+  return useAvx2() ? spanSpaceAvx2(str, length) : spanSpaceSse2(str, length);
+}
+
+size_t stringAsciiTrimEnd(const char *str, size_t length) {
+  return useAvx2() ? trimEndAvx2(str, length) : trimEndSse2(str, length);
+}
+
+#else
+
+void stringAsciiUpcase(char *str, size_t length) {
+  stringAsciiUpcaseScalar(str, length);
+}
+
+void stringAsciiDowncase(char *str, size_t length) {
+  stringAsciiDowncaseScalar(str, length);
+}
+
+size_t stringAsciiSpanSpace(const char *str, size_t length) {
+  return stringAsciiSpanSpaceScalar(str, length);
+}
+
+size_t stringAsciiTrimEnd(const char *str, size_t length) {
+  return stringAsciiTrimEndScalar(str, length);
+}
+
+#endif
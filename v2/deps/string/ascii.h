@@ -0,0 +1,47 @@
+/*
+  Copyright (c) 2022 William Cotton
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#ifndef STRING_ASCII_H
+#define STRING_ASCII_H
+
+#include <stddef.h>
+
+/*
+  ASCII case conversion and whitespace classification for string_t. Only
+  bytes 'a'-'z' / 'A'-'Z' change case and only " \t\n\v\f\r" count as
+  whitespace, independent of the current locale. On x86 the kernels process
+  16 (SSE2) or 32 (AVX2) bytes at a time, picked at runtime; the Scalar
+  versions are the reference implementation the tests compare against.
+*/
+void stringAsciiUpcase(char *str, size_t length);
+void stringAsciiDowncase(char *str, size_t length);
+// Number of leading whitespace bytes.
+size_t stringAsciiSpanSpace(const char *str, size_t length);
+// Length of str once trailing whitespace is removed.
+size_t stringAsciiTrimEnd(const char *str, size_t length);
+
+void stringAsciiUpcaseScalar(char *str, size_t length);
+void stringAsciiDowncaseScalar(char *str, size_t length);
+size_t stringAsciiSpanSpaceScalar(const char *str, size_t length);
+size_t stringAsciiTrimEndScalar(const char *str, size_t length);
+
+#endif // STRING_ASCII_H
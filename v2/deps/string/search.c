@@ -0,0 +1,198 @@
+/*
+  Copyright (c) 2022 William Cotton
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#define _GNU_SOURCE
+#include "search.h"
+#include <pthread.h>
+#include <string.h>
+
+// The SSE2 kernels are compiled without a target attribute, so they are
+// only built where the compiler may assume SSE2 (every x86-64 target, or
+// i386 with -msse2). That makes SSE2 the baseline: only AVX2 needs a
+// runtime check.
+#ifdef __SSE2__
+#include <immintrin.h>
+#define SEARCH_X86 1
+#endif
+
+typedef const char *(*search_fn)(const char *, size_t, const char *, size_t);
+
+static const char *searchFirstScalar(const char *haystack, size_t n,
+                                     const char *needle, size_t m) {
+  return memmem(haystack, n, needle, m);
+}
+
+static const char *searchLastScalar(const char *haystack, size_t n,
+                                    const char *needle, size_t m) {
+  for (size_t i = n - m + 1; i-- > 0;) {
+    if (haystack[i] == needle[0] && memcmp(haystack + i, needle, m) == 0) {
+      return haystack + i;
+    }
+  }
+  return NULL;
+}
+
+#ifdef SEARCH_X86
+
+// Both kernels require 2 <= m <= n; a set bit in mask is a position whose
+// first and last bytes match, so only the m - 2 bytes between need checking.
+#define SEARCH_CANDIDATE(h, i, bit, needle, m)                                 \
+  ((m) <= 2 || memcmp((h) + (i) + (bit) + 1, (needle) + 1, (m)-2) == 0)
+
+static const char *searchFirstSse2(const char *h, size_t n, const char *needle,
+                                   size_t m) {
+  const __m128i first = _mm_set1_epi8(needle[0]);
+  const __m128i last = _mm_set1_epi8(needle[m - 1]);
+  size_t i = 0;
+  for (; i + m - 1 + 16 <= n; i += 16) {
+    __m128i blockFirst = _mm_loadu_si128((const __m128i *)(h + i));
+    __m128i blockLast = _mm_loadu_si128((const __m128i *)(h + i + m - 1));
+    unsigned mask = _mm_movemask_epi8(_mm_and_si128(
+        _mm_cmpeq_epi8(first, blockFirst), _mm_cmpeq_epi8(last, blockLast)));
+    while (mask != 0) {
+      unsigned bit = __builtin_ctz(mask);
+      if (SEARCH_CANDIDATE(h, i, bit, needle, m)) {
+        return h + i + bit;
+      }
+      mask &= mask - 1;
+    }
+  }
+  return searchFirstScalar(h + i, n - i, needle, m);
+}
+
+static const char *searchLastSse2(const char *h, size_t n, const char *needle,
+                                  size_t m) {
+  const __m128i first = _mm_set1_epi8(needle[0]);
+  const __m128i last = _mm_set1_epi8(needle[m - 1]);
+  size_t end = n - m + 1;
+  while (end >= 16) {
+    size_t i = end - 16;
+    __m128i blockFirst = _mm_loadu_si128((const __m128i *)(h + i));
+    __m128i blockLast = _mm_loadu_si128((const __m128i *)(h + i + m - 1));
+    unsigned mask = _mm_movemask_epi8(_mm_and_si128(
+        _mm_cmpeq_epi8(first, blockFirst), _mm_cmpeq_epi8(last, blockLast)));
+    while (mask != 0) {
+      unsigned bit = 31 - __builtin_clz(mask);
+      if (SEARCH_CANDIDATE(h, i, bit, needle, m)) {
+        return h + i + bit;
+      }
+      mask &= ~(1u << bit);
+    }
+    end = i;
+  }
+  return end == 0 ? NULL : searchLastScalar(h, end + m - 1, needle, m);
+}
+
+__attribute__((target("avx2"))) static const char *
+searchFirstAvx2(const char *h, size_t n, const char *needle, size_t m) {
+  const __m256i first = _mm256_set1_epi8(needle[0]);
+  const __m256i last = _mm256_set1_epi8(needle[m - 1]);
+  size_t i = 0;
+  for (; i + m - 1 + 32 <= n; i += 32) {
+    __m256i blockFirst = _mm256_loadu_si256((const __m256i *)(h + i));
+    __m256i blockLast = _mm256_loadu_si256((const __m256i *)(h + i + m - 1));
+    unsigned mask = _mm256_movemask_epi8(
+        _mm256_and_si256(_mm256_cmpeq_epi8(first, blockFirst),
+                         _mm256_cmpeq_epi8(last, blockLast)));
+    while (mask != 0) {
+      unsigned bit = __builtin_ctz(mask);
+      if (SEARCH_CANDIDATE(h, i, bit, needle, m)) {
+        return h + i + bit;
+      }
+      mask &= mask - 1;
+    }
+  }
+  return searchFirstScalar(h + i, n - i, needle, m);
+}
+
+__attribute__((target("avx2"))) static const char *
+searchLastAvx2(const char *h, size_t n, const char *needle, size_t m) {
+  const __m256i first = _mm256_set1_epi8(needle[0]);
+  const __m256i last = _mm256_set1_epi8(needle[m - 1]);
+  size_t end = n - m + 1;
+  while (end >= 32) {
+    size_t i = end - 32;
+    __m256i blockFirst = _mm256_loadu_si256((const __m256i *)(h + i));
+    __m256i blockLast = _mm256_loadu_si256((const __m256i *)(h + i + m - 1));
+    unsigned mask = _mm256_movemask_epi8(
+        _mm256_and_si256(_mm256_cmpeq_epi8(first, blockFirst),
+                         _mm256_cmpeq_epi8(last, blockLast)));
+    while (mask != 0) {
+      unsigned bit = 31 - __builtin_clz(mask);
+      if (SEARCH_CANDIDATE(h, i, bit, needle, m)) {
+        return h + i + bit;
+      }
+      mask &= ~(1u << bit);
+    }
+    end = i;
+  }
+  return end == 0 ? NULL : searchLastScalar(h, end + m - 1, needle, m);
+}
+
+#endif
+
+static search_fn searchFirstKernel = NULL;
+static search_fn searchLastKernel = NULL;
+// Both kernels are chosen together, once, so concurrent first calls never
+// see one set and the other still NULL.
+static pthread_once_t searchResolved = PTHREAD_ONCE_INIT;
+
+static void searchResolve(void) {
+  searchFirstKernel = searchFirstScalar;
+  searchLastKernel = searchLastScalar;
+#ifdef SEARCH_X86
+  if (__builtin_cpu_supports("avx2")) {
+    searchFirstKernel = searchFirstAvx2;
+    searchLastKernel = searchLastAvx2;
+  } else {
+    searchFirstKernel = searchFirstSse2;
+    searchLastKernel = searchLastSse2;
+  }
+#endif
+}
+
+const char *stringSearchFirst(const char *haystack, size_t haystackLength,
+                              const char *needle, size_t needleLength) {
+  if (needleLength == 0) {
+    return haystack;
+  }
+  if (needleLength > haystackLength) {
+    return NULL;
+  }
+  if (needleLength == 1) {
+    return memchr(haystack, needle[0], haystackLength);
+  }
+  pthread_once(&searchResolved, searchResolve);
+  return searchFirstKernel(haystack, haystackLength, needle, needleLength);
+}
+
+const char *stringSearchLast(const char *haystack, size_t haystackLength,
+                             const char *needle, size_t needleLength) {
+  if (needleLength == 0) {
+    return haystack + haystackLength;
+  }
+  if (needleLength > haystackLength) {
+    return NULL;
+  }
+  pthread_once(&searchResolved, searchResolve);
+  return searchLastKernel(haystack, haystackLength, needle, needleLength);
+}
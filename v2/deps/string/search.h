@@ -0,0 +1,44 @@
+/*
+  Copyright (c) 2022 William Cotton
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in
+  all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+  THE SOFTWARE.
+*/
+
+#ifndef STRING_SEARCH_H
+#define STRING_SEARCH_H
+
+#include <stddef.h>
+
+/*
+  Substring search kernels behind stringIndexOf, stringLastIndexOf,
+  stringContains and stringReplaceAll. On x86 they filter candidate
+  positions by comparing the needle's first and last bytes against 16 or
+  32 haystack bytes at a time (SSE2, or AVX2 when the CPU has it) and only
+  memcmp the middle of real candidates; everywhere else, and for the tail,
+  they fall back to memchr/memmem.
+
+  Both return a pointer to the match or NULL. An empty needle matches at
+  the start (or end, for stringSearchLast) of the haystack.
+*/
+const char *stringSearchFirst(const char *haystack, size_t haystackLength,
+                              const char *needle, size_t needleLength);
+const char *stringSearchLast(const char *haystack, size_t haystackLength,
+                             const char *needle, size_t needleLength);
+
+#endif // STRING_SEARCH_H
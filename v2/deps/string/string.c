@@ -21,6 +21,8 @@
 */
 
 #include "string.h"
+#include "ascii.h"
+#include "search.h"
 #include <Block.h>
 
 static int compare_strings(const void *a, const void *b) {
@@ -29,6 +31,91 @@ static int compare_strings(const void *a, const void *b) {
   return strcmp(s1->value, s2->value);
 }
 
+static void *stringMalloc(arena_t *arena, size_t size) {
+  return arena ? arenaAlloc(arena, size) : malloc(size);
+}
+
+static void stringRelease(arena_t *arena, void *ptr) {
+  if (arena == NULL) {
+    free(ptr);
+  }
+}
+
+static int stringIsInline(string_t *s) { return s->value == s->inlineValue; }
+
+static void stringInit(string_t *s, const char *str, size_t length) {
+  if (length <= STRING_INLINE_CAPACITY) {
+    s->value = s->inlineValue;
+    s->capacity = STRING_INLINE_CAPACITY;
+  } else {
+    s->value = stringMalloc(s->arena, length + 1);
+    s->capacity = length;
+  }
+  memcpy(s->value, str, length);
+  s->value[length] = '\0';
+  s->size = length;
+  s->hash = 0;
+  s->flags = 0;
+}
+
+static string_t *stringWithLength(arena_t *arena, const char *str,
+                                  size_t length) {
+  string_t *s = stringMalloc(arena, sizeof(string_t));
+  s->arena = arena;
+  stringInit(s, str, length);
+  return s;
+}
+
+// An empty string whose buffer already holds capacity bytes, for callers
+// that write the characters in place.
+static string_t *stringWithCapacity(arena_t *arena, size_t capacity) {
+  string_t *s = stringWithLength(arena, "", 0);
+  if (capacity > STRING_INLINE_CAPACITY) {
+    s->value = stringMalloc(arena, capacity + 1);
+    s->value[0] = '\0';
+    s->capacity = capacity;
+  }
+  return s;
+}
+
+static void stringReserve(string_t *s, size_t capacity) {
+  if (capacity <= s->capacity) {
+    return;
+  }
+  size_t newCapacity = s->capacity * 2;
+  while (newCapacity < capacity) {
+    newCapacity *= 2;
+  }
+  if (stringIsInline(s)) {
+    char *value = stringMalloc(s->arena, newCapacity + 1);
+    memcpy(value, s->value, s->size + 1);
+    s->value = value;
+  } else if (s->arena) {
+    s->value =
+        arenaRealloc(s->arena, s->value, s->capacity + 1, newCapacity + 1);
+  } else {
+    s->value = realloc(s->value, newCapacity + 1);
+  }
+  s->capacity = newCapacity;
+}
+
+// Replaces the characters with a buffer from stringMalloc of the given size.
+static void stringAdopt(string_t *s, char *value, size_t size) {
+  if (!stringIsInline(s)) {
+    stringRelease(s->arena, s->value);
+  }
+  if (size <= STRING_INLINE_CAPACITY) {
+    memcpy(s->inlineValue, value, size + 1);
+    stringRelease(s->arena, value);
+    s->value = s->inlineValue;
+    s->capacity = STRING_INLINE_CAPACITY;
+  } else {
+    s->value = value;
+    s->capacity = size;
+  }
+  s->size = size;
+}
+
 char *stringErrorMessage(int error) {
   switch (error) {
   case 0:
@@ -50,448 +137,713 @@ char *stringErrorMessage(int error) {
   }
 }
 
-string_collection_t *stringCollection(size_t size, string_t **array) {
-  string_collection_t *collection = malloc(sizeof(string_collection_t));
+string_collection_t *stringCollectionInArena(arena_t *arena, size_t size,
+                                             string_t **array) {
+  string_collection_t *collection =
+      stringMalloc(arena, sizeof(string_collection_t));
   collection->size = size;
+  collection->capacity = size;
   collection->arr = array;
+  collection->arena = arena;
+  return collection;
+}
 
-  collection->mallocCount = 0;
-  collection->malloc = Block_copy(^(size_t msize) {
-    void *ptr = malloc(msize);
-    collection->mallocs[collection->mallocCount++] = (malloc_t){.ptr = ptr};
-    return ptr;
-  });
-
-  collection->blockCopyCount = 0;
-  collection->blockCopy = Block_copy(^(void *block) {
-    void *ptr = Block_copy(block);
-    collection->blockCopies[collection->blockCopyCount++] =
-        (malloc_t){.ptr = ptr};
-    return ptr;
-  });
-
-  collection->each = collection->blockCopy(^(eachStringCallback callback) {
-    for (size_t i = 0; i < collection->size; i++) {
-      callback(collection->arr[i]);
-    }
-  });
+string_collection_t *stringCollection(size_t size, string_t **array) {
+  return stringCollectionInArena(NULL, size, array);
+}
 
-  collection->eachWithIndex =
-      collection->blockCopy(^(eachStringWithIndexCallback callback) {
-        for (size_t i = 0; i < collection->size; i++) {
-          callback(collection->arr[i], i);
-        }
-      });
+void stringCollectionEach(string_collection_t *collection,
+                          eachStringCallback callback) {
+  for (size_t i = 0; i < collection->size; i++) {
+    callback(collection->arr[i]);
+  }
+}
 
-  collection->reduce = collection->blockCopy(
-      ^(void *accumulator, reducerStringCallback reducer) {
-        for (size_t i = 0; i < collection->size; i++) {
-          accumulator = reducer(accumulator, collection->arr[i]);
-        }
-        return accumulator;
-      });
+void stringCollectionEachWithIndex(string_collection_t *collection,
+                                   eachStringWithIndexCallback callback) {
+  for (size_t i = 0; i < collection->size; i++) {
+    callback(collection->arr[i], i);
+  }
+}
 
-  collection->map = collection->blockCopy(^(mapStringCallback callback) {
-    void **arr = collection->malloc(sizeof(void *) * collection->size);
-    for (size_t i = 0; i < collection->size; i++) {
-      arr[i] = callback(collection->arr[i]);
-    }
-    return arr;
-  });
-
-  collection->reverse = collection->blockCopy(^(void) {
-    for (size_t i = 0; i < collection->size / 2; i++) {
-      string_t *tmp = collection->arr[i];
-      collection->arr[i] = collection->arr[collection->size - i - 1];
-      collection->arr[collection->size - i - 1] = tmp;
-    }
-    return collection;
-  });
+void *stringCollectionReduce(string_collection_t *collection,
+                             void *accumulator, reducerStringCallback reducer) {
+  for (size_t i = 0; i < collection->size; i++) {
+    accumulator = reducer(accumulator, collection->arr[i]);
+  }
+  return accumulator;
+}
 
-  collection->push = collection->blockCopy(^(string_t *string) {
-    collection->size++;
-    collection->arr =
-        realloc(collection->arr, collection->size * sizeof(string_t *));
-    collection->arr[collection->size - 1] = string;
-    return collection;
-  });
+void **stringCollectionMap(string_collection_t *collection,
+                           mapStringCallback callback) {
+  void **arr =
+      stringMalloc(collection->arena, sizeof(void *) * collection->size);
+  for (size_t i = 0; i < collection->size; i++) {
+    arr[i] = callback(collection->arr[i]);
+  }
+  return arr;
+}
+
+string_collection_t *stringCollectionReverse(string_collection_t *collection) {
+  for (size_t i = 0; i < collection->size / 2; i++) {
+    string_t *tmp = collection->arr[i];
+    collection->arr[i] = collection->arr[collection->size - i - 1];
+    collection->arr[collection->size - i - 1] = tmp;
+  }
+  return collection;
+}
 
-  collection->sort = collection->blockCopy(^{
-    // sort strings with qsort
-    qsort(collection->arr, collection->size, sizeof(string_t *),
-          compare_strings);
+string_collection_t *stringCollectionReserve(string_collection_t *collection,
+                                             size_t capacity) {
+  if (capacity <= collection->capacity) {
     return collection;
-  });
+  }
+  if (collection->arena) {
+    collection->arr = arenaRealloc(collection->arena, collection->arr,
+                                   collection->capacity * sizeof(string_t *),
+                                   capacity * sizeof(string_t *));
+  } else {
+    collection->arr = realloc(collection->arr, capacity * sizeof(string_t *));
+  }
+  collection->capacity = capacity;
+  return collection;
+}
+
+string_collection_t *stringCollectionPush(string_collection_t *collection,
+                                          string_t *string) {
+  if (collection->size == collection->capacity) {
+    stringCollectionReserve(
+        collection, collection->capacity < 8 ? 8 : collection->capacity * 2);
+  }
+  collection->arr[collection->size++] = string;
+  return collection;
+}
+
+string_collection_t *stringCollectionSort(string_collection_t *collection) {
+  // sort strings with qsort
+  qsort(collection->arr, collection->size, sizeof(string_t *), compare_strings);
+  return collection;
+}
 
-  collection->join = collection->blockCopy(^(const char *delim) {
-    size_t delimSize = strlen(delim);
-    if (collection->size == 0) {
-      return string("");
+static size_t joinedSize(string_collection_t *collection, size_t delimSize) {
+  if (collection->size == 0) {
+    return 0;
+  }
+  size_t len = (collection->size - 1) * delimSize;
+  for (size_t i = 0; i < collection->size; i++) {
+    len += collection->arr[i]->size;
+  }
+  return len;
+}
+
+// Sizes the result exactly and copies each element once, straight into the
+// returned string's buffer.
+string_t *stringCollectionJoin(string_collection_t *collection,
+                               const char *delim) {
+  size_t delimSize = strlen(delim);
+  size_t len = joinedSize(collection, delimSize);
+  string_t *joined = stringWithCapacity(collection->arena, len);
+  char *out = joined->value;
+  for (size_t i = 0; i < collection->size; i++) {
+    if (i > 0) {
+      memcpy(out, delim, delimSize);
+      out += delimSize;
     }
-    size_t len = 0;
-    for (size_t i = 0; i < collection->size; i++) {
-      len += collection->arr[i]->size;
+    memcpy(out, collection->arr[i]->value, collection->arr[i]->size);
+    out += collection->arr[i]->size;
+  }
+  *out = '\0';
+  joined->size = len;
+  return joined;
+}
+
+int stringCollectionJoinToFile(string_collection_t *collection,
+                               const char *delim, FILE *file) {
+  size_t delimSize = strlen(delim);
+  for (size_t i = 0; i < collection->size; i++) {
+    if (i > 0 && fwrite(delim, 1, delimSize, file) != delimSize) {
+      return -1;
     }
-    len += collection->size - 1;
-    char *str = malloc(len + 1);
-    str[0] = '\0';
-    for (size_t i = 0; i < collection->size; i++) {
-      strlcat(str, collection->arr[i]->value,
-              len + 1 + collection->arr[i]->size);
-      if (i < collection->size - 1) {
-        strlcat(str, delim, len + 1 + delimSize);
-      }
+    string_t *s = collection->arr[i];
+    if (fwrite(s->value, 1, s->size, file) != s->size) {
+      return -1;
     }
-    string_t *temp = string(str);
-    free(str);
-    return temp;
-  });
-
-  collection->indexOf = collection->blockCopy(^(const char *str) {
-    for (int i = 0; i < (int)collection->size; i++) {
-      if (strcmp(collection->arr[i]->value, str) == 0) {
-        return i;
+  }
+  return 0;
+}
+
+// Writes elements and delimiters with writev, STRING_JOIN_IOV_COUNT
+// buffers per call, resuming after partial writes.
+int stringCollectionJoinToFd(string_collection_t *collection,
+                             const char *delim, int fd) {
+  size_t delimSize = strlen(delim);
+  struct iovec iov[STRING_JOIN_IOV_COUNT];
+  size_t next = 0;
+  int pendingDelim = 0;
+  while (next < collection->size) {
+    int count = 0;
+    while (count < STRING_JOIN_IOV_COUNT && next < collection->size) {
+      if (pendingDelim) {
+        iov[count++] = (struct iovec){(void *)delim, delimSize};
+        pendingDelim = 0;
+      } else {
+        string_t *s = collection->arr[next++];
+        iov[count++] = (struct iovec){s->value, s->size};
+        pendingDelim = next < collection->size && delimSize > 0;
       }
     }
-    return -1;
-  });
-
-  collection->first = collection->blockCopy(^{
-    return collection->arr[0];
-  });
-  collection->second = collection->blockCopy(^{
-    return collection->arr[1];
-  });
-  collection->third = collection->blockCopy(^{
-    return collection->arr[2];
-  });
-  collection->fourth = collection->blockCopy(^{
-    return collection->arr[3];
-  });
-  collection->fifth = collection->blockCopy(^{
-    return collection->arr[4];
-  });
-  collection->last = collection->blockCopy(^{
-    return collection->arr[collection->size - 1];
-  });
-
-  collection->free = Block_copy(^(void) {
-    for (size_t i = 0; i < collection->size; i++) {
-      collection->arr[i]->free();
+    struct iovec *cursor = iov;
+    while (count > 0) {
+      ssize_t written = writev(fd, cursor, count);
+      if (written < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return -1;
+      }
+      while (count > 0 && (size_t)written >= cursor->iov_len) {
+        written -= cursor->iov_len;
+        cursor++;
+        count--;
+      }
+      if (count > 0) {
+        cursor->iov_base = (char *)cursor->iov_base + written;
+        cursor->iov_len -= written;
+      }
     }
-    free(collection->arr);
+  }
+  return 0;
+}
 
-    for (int i = 0; i < collection->mallocCount; i++) {
-      free(collection->mallocs[i].ptr);
-    }
-    for (int i = 0; i < collection->blockCopyCount; i++) {
-      Block_release(collection->blockCopies[i].ptr);
+int stringCollectionIndexOf(string_collection_t *collection, const char *str) {
+  for (int i = 0; i < (int)collection->size; i++) {
+    if (strcmp(collection->arr[i]->value, str) == 0) {
+      return i;
     }
-    Block_release(collection->blockCopy);
+  }
+  return -1;
+}
 
-    dispatch_async(dispatch_get_main_queue(), ^() {
-      Block_release(collection->free);
-      free(collection);
-    });
-  });
+string_t *stringCollectionFirst(string_collection_t *collection) {
+  return collection->arr[0];
+}
 
-  return collection;
+string_t *stringCollectionSecond(string_collection_t *collection) {
+  return collection->arr[1];
+}
+
+string_t *stringCollectionThird(string_collection_t *collection) {
+  return collection->arr[2];
+}
+
+string_t *stringCollectionFourth(string_collection_t *collection) {
+  return collection->arr[3];
+}
+
+string_t *stringCollectionFifth(string_collection_t *collection) {
+  return collection->arr[4];
+}
+
+string_t *stringCollectionLast(string_collection_t *collection) {
+  return collection->arr[collection->size - 1];
+}
+
+void stringCollectionFree(string_collection_t *collection) {
+  if (collection->arena) {
+    return;
+  }
+  for (size_t i = 0; i < collection->size; i++) {
+    stringFree(collection->arr[i]);
+  }
+  free(collection->arr);
+  free(collection);
 }
 
 string_t *string(const char *strng) {
-  string_t *s = malloc(sizeof(string_t));
-  s->value = strdup(strng);
-  s->size = strlen(s->value);
-
-  s->blockCopyCount = 0;
-  s->blockCopy = Block_copy(^(void *block) {
-    void *ptr = Block_copy(block);
-    s->blockCopies[s->blockCopyCount++] = (malloc_t){.ptr = ptr};
-    return ptr;
-  });
-
-  s->print = s->blockCopy(^(void) {
-    printf("%s\n", s->value);
-  });
-
-  s->concat = s->blockCopy(^(const char *str) {
-    size_t size = s->size + strlen(str);
-    char *new_str = malloc(size + 1);
-    strlcpy(new_str, s->value, size + 1);
-    strlcat(new_str, str, size + 1);
-    free(s->value);
-    s->value = new_str;
-    s->size = size;
-    return s;
-  });
+  return stringWithLength(NULL, strng, strlen(strng));
+}
 
-  s->upcase = s->blockCopy(^(void) {
-    for (size_t i = 0; i < s->size; i++) {
-      s->value[i] = toupper(s->value[i]);
-    }
-    return s;
-  });
+string_t *stringInArena(arena_t *arena, const char *str) {
+  return stringWithLength(arena, str, strlen(str));
+}
 
-  s->downcase = s->blockCopy(^(void) {
-    for (size_t i = 0; i < s->size; i++) {
-      s->value[i] = tolower(s->value[i]);
-    }
-    return s;
-  });
+void stringPrint(string_t *s) { printf("%s\n", s->value); }
 
-  s->capitalize = s->blockCopy(^(void) {
-    for (size_t i = 0; i < s->size; i++) {
-      if (i == 0) {
-        s->value[i] = toupper(s->value[i]);
-      } else {
-        s->value[i] = tolower(s->value[i]);
-      }
-    }
-    return s;
-  });
+string_t *stringConcat(string_t *s, const char *str) {
+  size_t length = strlen(str);
+  stringReserve(s, s->size + length);
+  memcpy(s->value + s->size, str, length + 1);
+  s->size += length;
+  return s;
+}
 
-  s->reverse = s->blockCopy(^(void) {
-    char *new_str = malloc(s->size + 1);
-    for (size_t i = 0; i < s->size; i++) {
-      new_str[s->size - i - 1] = s->value[i];
-    }
-    new_str[s->size] = '\0';
-    free(s->value);
-    s->value = new_str;
-    return s;
-  });
+string_t *stringUpcase(string_t *s) {
+  stringAsciiUpcase(s->value, s->size);
+  return s;
+}
 
-  s->trim = s->blockCopy(^(void) {
-    size_t start = 0;
-    size_t end = s->size - 1;
-    while (isspace(s->value[start])) {
-      start++;
-    }
-    while (isspace(s->value[end])) {
-      end--;
-    }
-    size_t size = end - start + 1;
-    char *new_str = malloc(size + 1);
-    strncpy(new_str, s->value + start, size);
-    new_str[size] = '\0';
-    free(s->value);
-    s->value = new_str;
-    s->size = size;
+string_t *stringDowncase(string_t *s) {
+  stringAsciiDowncase(s->value, s->size);
+  return s;
+}
+
+string_t *stringCapitalize(string_t *s) {
+  stringAsciiDowncase(s->value, s->size);
+  stringAsciiUpcase(s->value, s->size > 0 ? 1 : 0);
+  return s;
+}
+
+string_t *stringReverse(string_t *s) {
+  for (size_t i = 0; i < s->size / 2; i++) {
+    char tmp = s->value[i];
+    s->value[i] = s->value[s->size - i - 1];
+    s->value[s->size - i - 1] = tmp;
+  }
+  return s;
+}
+
+// Trims ASCII whitespace in place without reallocating.
+string_t *stringTrim(string_t *s) {
+  size_t start = stringAsciiSpanSpace(s->value, s->size);
+  size_t size = stringAsciiTrimEnd(s->value + start, s->size - start);
+  if (start > 0) {
+    memmove(s->value, s->value + start, size);
+  }
+  s->value[size] = '\0';
+  s->size = size;
+  return s;
+}
+
+string_view_t stringView(string_t *s) {
+  return (string_view_t){.start = s->value, .length = s->size};
+}
+
+string_view_t stringViewTrim(string_view_t view) {
+  size_t start = stringAsciiSpanSpace(view.start, view.length);
+  return (string_view_t){
+      .start = view.start + start,
+      .length = stringAsciiTrimEnd(view.start + start, view.length - start)};
+}
+
+string_t *stringFromView(string_view_t view) {
+  return stringWithLength(NULL, view.start, view.length);
+}
+
+int stringViewEql(string_view_t view, const char *str) {
+  return strncmp(view.start, str, view.length) == 0 &&
+         str[view.length] == '\0';
+}
+
+string_split_iterator_t stringViewSplit(string_view_t view, const char *delim) {
+  string_split_iterator_t iterator = {.cursor = view.start,
+                                      .end = view.start + view.length,
+                                      .delims = {0, 0, 0, 0}};
+  for (const unsigned char *d = (const unsigned char *)delim; *d; d++) {
+    iterator.delims[*d >> 6] |= 1ull << (*d & 63);
+  }
+  return iterator;
+}
+
+string_split_iterator_t stringSplitView(string_t *s, const char *delim) {
+  return stringViewSplit(stringView(s), delim);
+}
+
+static inline int isDelim(string_split_iterator_t *iterator, char c) {
+  unsigned char u = (unsigned char)c;
+  return (iterator->delims[u >> 6] >> (u & 63)) & 1;
+}
+
+int stringSplitViewNext(string_split_iterator_t *iterator,
+                        string_view_t *token) {
+  const char *cursor = iterator->cursor;
+  while (cursor < iterator->end && isDelim(iterator, *cursor)) {
+    cursor++;
+  }
+  if (cursor == iterator->end) {
+    iterator->cursor = cursor;
+    return 0;
+  }
+  const char *start = cursor;
+  while (cursor < iterator->end && !isDelim(iterator, *cursor)) {
+    cursor++;
+  }
+  token->start = start;
+  token->length = cursor - start;
+  iterator->cursor = cursor;
+  return 1;
+}
+
+// Splits on any of the characters in delim, skipping empty tokens like
+// strtok. Tokens are counted first so the array is allocated exactly once.
+string_collection_t *stringSplit(string_t *s, const char *delim) {
+  string_collection_t *collection = stringCollectionInArena(s->arena, 0, NULL);
+  string_split_iterator_t iterator = stringSplitView(s, delim);
+  string_view_t token;
+  size_t count = 0;
+  while (stringSplitViewNext(&iterator, &token)) {
+    count++;
+  }
+  stringCollectionReserve(collection, count);
+  iterator = stringSplitView(s, delim);
+  while (stringSplitViewNext(&iterator, &token)) {
+    collection->arr[collection->size++] =
+        stringWithLength(s->arena, token.start, token.length);
+  }
+  return collection;
+}
+
+integer_number_t stringToInt(string_t *s) {
+  return stringParseInteger(s->value, s->size);
+}
+
+decimal_number_t stringToDecimal(string_t *s) {
+  return stringParseDecimal(s->value, s->size);
+}
+
+// Replaces every non-overlapping occurrence of str1. Matches are counted
+// first so the result is written into one exactly sized buffer.
+string_t *stringReplaceAll(string_t *s, const char *str1, const char *str2) {
+  size_t str1_len = strlen(str1);
+  size_t str2_len = strlen(str2);
+  if (str1_len == 0) {
     return s;
-  });
-
-  s->split = s->blockCopy(^(const char *delim) {
-    string_collection_t *collection = stringCollection(0, NULL);
-    collection->size = 0;
-    collection->arr = malloc(sizeof(string_t *));
-    char *tknPtr;
-    char *token = strtok_r(s->value, delim, &tknPtr);
-    while (token != NULL) {
-      collection->size++;
-      collection->arr =
-          realloc(collection->arr, collection->size * sizeof(string_t *));
-      collection->arr[collection->size - 1] = string(token);
-      token = strtok_r(NULL, delim, &tknPtr);
+  }
+  const char *end = s->value + s->size;
+  size_t count = 0;
+  for (const char *match = s->value;
+       (match = stringSearchFirst(match, end - match, str1, str1_len));
+       match += str1_len) {
+    count++;
+  }
+  if (count == 0) {
+    return s;
+  }
+  size_t newStrLen = s->size - count * str1_len + count * str2_len;
+  char *newStr = stringMalloc(s->arena, newStrLen + 1);
+  const char *cursor = s->value;
+  char *out = newStr;
+  for (size_t i = 0; i < count; i++) {
+    const char *match = stringSearchFirst(cursor, end - cursor, str1, str1_len);
+    memcpy(out, cursor, match - cursor);
+    out += match - cursor;
+    memcpy(out, str2, str2_len);
+    out += str2_len;
+    cursor = match + str1_len;
+  }
+  memcpy(out, cursor, end - cursor);
+  newStr[newStrLen] = '\0';
+  stringAdopt(s, newStr, newStrLen);
+  return s;
+}
+
+string_t *stringReplace(string_t *s, const char *str1, const char *str2) {
+  return stringReplaceAll(s, str1, str2);
+}
+
+string_t *stringDelete(string_t *s, const char *str) {
+  return stringReplace(s, str, "");
+}
+
+string_t *stringChomp(string_t *s) {
+  if (s->size > 0 && s->value[s->size - 1] == '\n') {
+    s->value[s->size - 1] = '\0';
+    s->size--;
+  }
+  return s;
+}
+
+string_t *stringSlice(string_t *s, size_t start, size_t length) {
+  if (start >= s->size) {
+    return stringWithLength(s->arena, "", 0);
+  }
+  if (start + length > s->size) {
+    length = s->size - start;
+  }
+  return stringWithLength(s->arena, s->value + start, length);
+}
+
+int stringIndexOf(string_t *s, const char *str) {
+  const char *match = stringSearchFirst(s->value, s->size, str, strlen(str));
+  return match ? (int)(match - s->value) : -1;
+}
+
+int stringLastIndexOf(string_t *s, const char *str) {
+  const char *match = stringSearchLast(s->value, s->size, str, strlen(str));
+  return match ? (int)(match - s->value) : -1;
+}
+
+int stringEql(string_t *s, const char *str) {
+  return strcmp(s->value, str) == 0;
+}
+
+int stringEquals(string_t *a, string_t *b) {
+  if (a == b) {
+    return 1;
+  }
+  if ((a->flags & b->flags & STRING_FLAG_INTERNED) != 0) {
+    return 0;
+  }
+  return a->size == b->size && memcmp(a->value, b->value, a->size) == 0;
+}
+
+// FNV-1a
+static uint32_t hashBytes(const char *str, size_t length) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < length; i++) {
+    hash ^= (uint8_t)str[i];
+    hash *= 16777619;
+  }
+  return hash;
+}
+
+uint32_t stringHash(string_t *s) {
+  if (s->flags & STRING_FLAG_INTERNED) {
+    return s->hash;
+  }
+  return hashBytes(s->value, s->size);
+}
+
+int stringContains(string_t *s, const char *str) {
+  return stringIndexOf(s, str) != -1;
+}
+
+string_regex_t *stringRegex(const char *pattern) {
+  string_regex_t *regex = malloc(sizeof(string_regex_t));
+  if (regcomp(&regex->compiled, pattern, REG_EXTENDED)) {
+    log_err("regcomp() failed");
+    free(regex);
+    return NULL;
+  }
+  regex->pattern = strdup(pattern);
+  regex->groups = regex->compiled.re_nsub + 1;
+  regex->matches = malloc(regex->groups * sizeof(regmatch_t));
+  regex->cached = 0;
+  return regex;
+}
+
+void stringRegexFree(string_regex_t *regex) {
+  if (regex == NULL || regex->cached) {
+    return;
+  }
+  regfree(&regex->compiled);
+  free(regex->matches);
+  free(regex->pattern);
+  free(regex);
+}
+
+/*
+  Most recently used first. A hit moves the entry to the front and a miss
+  evicts the entry at the back once the cache is full.
+*/
+static struct {
+  string_regex_t *entries[STRING_REGEX_CACHE_SIZE];
+  size_t count;
+} regexCache = {{NULL}, 0};
+
+string_regex_t *stringRegexCached(const char *pattern) {
+  for (size_t i = 0; i < regexCache.count; i++) {
+    string_regex_t *regex = regexCache.entries[i];
+    if (strcmp(regex->pattern, pattern) == 0) {
+      memmove(&regexCache.entries[1], &regexCache.entries[0],
+              i * sizeof(string_regex_t *));
+      regexCache.entries[0] = regex;
+      return regex;
     }
+  }
+  string_regex_t *regex = stringRegex(pattern);
+  if (regex == NULL) {
+    return NULL;
+  }
+  if (regexCache.count == STRING_REGEX_CACHE_SIZE) {
+    string_regex_t *evicted = regexCache.entries[--regexCache.count];
+    evicted->cached = 0;
+    stringRegexFree(evicted);
+  }
+  memmove(&regexCache.entries[1], &regexCache.entries[0],
+          regexCache.count * sizeof(string_regex_t *));
+  regexCache.entries[0] = regex;
+  regexCache.count++;
+  regex->cached = 1;
+  return regex;
+}
+
+size_t stringRegexCacheCount(void) { return regexCache.count; }
+
+void stringRegexCacheFree(void) {
+  for (size_t i = 0; i < regexCache.count; i++) {
+    regexCache.entries[i]->cached = 0;
+    stringRegexFree(regexCache.entries[i]);
+  }
+  regexCache.count = 0;
+}
+
+// Collects the capture groups of every match, in order. Groups that did not
+// take part in a match are pushed as empty strings so positions line up.
+string_collection_t *stringMatchGroupRegex(string_t *s, string_regex_t *regex) {
+  string_collection_t *collection = stringCollectionInArena(s->arena, 0, NULL);
+  if (regex == NULL) {
     return collection;
-  });
-
-  s->toInt = s->blockCopy(^(void) {
-    char *nptr = s->value;
-    char *endptr = NULL;
-    int error = 0;
-    long long number;
-    errno = 0;
-    number = strtoll(nptr, &endptr, 10);
-    if (nptr == endptr) {
-      error = NUMBER_ERROR_NO_DIGITS;
-    } else if (errno == ERANGE && number == LLONG_MIN) {
-      error = NUMBER_ERROR_UNDERFLOW;
-    } else if (errno == ERANGE && number == LLONG_MAX) {
-      error = NUMBER_ERROR_OVERFLOW;
-    } else if (errno == EINVAL) { /* not in all c99 implementations - gcc OK */
-      error = NUMBER_ERROR_BASE_UNSUPPORTED;
-    } else if (errno != 0 && number == 0) {
-      error = NUMBER_ERROR_UNSPECIFIED;
-    } else if (errno == 0 && nptr && *endptr != 0) {
-      error = NUMBER_ERROR_ADDITIONAL_CHARACTERS;
-    }
-    integer_number_t n;
-    if (error == 0 || error == NUMBER_ERROR_ADDITIONAL_CHARACTERS) {
-      n.value = number;
-    } else {
-      n.value = 0;
-    }
-    n.error = error;
-    return n;
-  });
-
-  s->toDecimal = s->blockCopy(^(void) {
-    char *nptr = s->value;
-    char *endptr = NULL;
-    int error = 0;
-    long double number;
-    errno = 0;
-    number = strtold(nptr, &endptr);
-    if (nptr == endptr) {
-      error = NUMBER_ERROR_NO_DIGITS;
-    } else if (errno == ERANGE && number == -HUGE_VALL) {
-      error = NUMBER_ERROR_UNDERFLOW;
-    } else if (errno == ERANGE && number == HUGE_VALL) {
-      error = NUMBER_ERROR_OVERFLOW;
-    } else if (errno == EINVAL) { /* not in all c99 implementations - gcc OK */
-      error = NUMBER_ERROR_BASE_UNSUPPORTED;
-    } else if (errno != 0 && number == 0) {
-      error = NUMBER_ERROR_UNSPECIFIED;
-    } else if (errno == 0 && nptr && *endptr != 0) {
-      error = NUMBER_ERROR_ADDITIONAL_CHARACTERS;
-    }
-    decimal_number_t n;
-    if (error == 0 || error == NUMBER_ERROR_ADDITIONAL_CHARACTERS) {
-      n.value = number;
-    } else {
-      n.value = 0;
+  }
+  regmatch_t *matches = regex->matches;
+  size_t offset = 0;
+  while (offset <= s->size) {
+    int flags = offset > 0 ? REG_NOTBOL : 0;
+#ifdef REG_STARTEND
+    // Bound the search explicitly so regexec does not strlen the remaining
+    // input on every match; offsets are then relative to s->value.
+    const char *base = s->value;
+    matches[0].rm_so = offset;
+    matches[0].rm_eo = s->size;
+    flags |= REG_STARTEND;
+#else
+    const char *base = s->value + offset;
+#endif
+    if (regexec(&regex->compiled, base, regex->groups, matches, flags)) {
+      break; // No more matches
     }
-    n.error = error;
-    return n;
-  });
-
-  s->replace = s->blockCopy(^(const char *str1, const char *str2) {
-    size_t str1_len = strlen(str1);
-    size_t str2_len = strlen(str2);
-    size_t newStrLen = s->size + str2_len - str1_len + 1;
-    char *newStr = malloc(newStrLen);
-    size_t i = 0;
-    size_t j = 0;
-    while (i < s->size) {
-      if (strncmp(s->value + i, str1, strlen(str1)) == 0) {
-        strlcpy(newStr + j, str2, newStrLen);
-        i += strlen(str1);
-        j += strlen(str2);
+    for (size_t g = 1; g < regex->groups; g++) {
+      if (matches[g].rm_so < 0) {
+        stringCollectionPush(collection, stringWithLength(s->arena, "", 0));
       } else {
-        newStr[j] = s->value[i];
-        i++;
-        j++;
+        stringCollectionPush(
+            collection,
+            stringWithLength(s->arena, base + matches[g].rm_so,
+                             matches[g].rm_eo - matches[g].rm_so));
       }
     }
-    newStr[j] = '\0';
+    // Step past an empty match so the scan always makes progress.
+    size_t end = base - s->value + matches[0].rm_eo;
+    offset = end > offset ? end : offset + 1;
+  }
+  return collection;
+}
+
+string_collection_t *stringMatchGroup(string_t *s, const char *regex) {
+  return stringMatchGroupRegex(s, stringRegexCached(regex));
+}
+
+void stringFree(string_t *s) {
+  if (s->arena || (s->flags & STRING_FLAG_INTERNED)) {
+    return;
+  }
+  if (!stringIsInline(s)) {
     free(s->value);
-    s->value = newStr;
-    s->size = j;
-    return s;
-  });
+  }
+  free(s);
+}
 
-  s->chomp = s->blockCopy(^(void) {
-    if (s->value[s->size - 1] == '\n') {
-      s->value[s->size - 1] = '\0';
-      s->size--;
-    }
-    return s;
-  });
+static struct {
+  struct {
+    void *ptr;
+    int isCollection;
+  } *entries;
+  size_t count;
+  size_t capacity;
+} retired = {NULL, 0, 0};
+
+static void retire(void *ptr, int isCollection) {
+  if (retired.count == retired.capacity) {
+    retired.capacity = retired.capacity < 64 ? 64 : retired.capacity * 2;
+    retired.entries =
+        realloc(retired.entries, retired.capacity * sizeof(*retired.entries));
+  }
+  retired.entries[retired.count].ptr = ptr;
+  retired.entries[retired.count].isCollection = isCollection;
+  retired.count++;
+}
 
-  s->slice = s->blockCopy(^(size_t start, size_t length) {
-    if (start >= s->size) {
-      return string("");
-    }
-    if (start + length > s->size) {
-      length = s->size - start;
-    }
-    char *new_str = malloc(length + 1);
-    strncpy(new_str, s->value + start, length);
-    new_str[length] = '\0';
-    string_t *temp = string(new_str);
-    free(new_str);
-    return temp;
-  });
-
-  s->indexOf = s->blockCopy(^(const char *str) {
-    for (int i = 0; i < (int)s->size; i++) {
-      if (strncmp(s->value + i, str, strlen(str)) == 0) {
-        return i;
-      }
-    }
-    return -1;
-  });
+void stringRetire(string_t *s) { retire(s, 0); }
 
-  s->lastIndexOf = s->blockCopy(^(const char *str) {
-    for (int i = s->size - 1; i > 0; i--) {
-      if (strncmp(s->value + i, str, strlen(str)) == 0) {
-        return i;
-      }
-    }
-    return -1;
-  });
-
-  s->eql = s->blockCopy(^(const char *str) {
-    return strcmp(s->value, str) == 0;
-  });
-
-  s->contains = s->blockCopy(^(const char *str) {
-    return s->indexOf(str) != -1;
-  });
-
-  s->split = s->blockCopy(^(const char *delim) {
-    string_collection_t *collection = stringCollection(0, NULL);
-    char *tknPtr;
-    char *token = strtok_r(s->value, delim, &tknPtr);
-    while (token != NULL) {
-      collection->push(string(token));
-      token = strtok_r(NULL, delim, &tknPtr);
+void stringCollectionRetire(string_collection_t *collection) {
+  retire(collection, 1);
+}
+
+size_t stringReclaim(void) {
+  size_t count = retired.count;
+  for (size_t i = 0; i < count; i++) {
+    if (retired.entries[i].isCollection) {
+      stringCollectionFree(retired.entries[i].ptr);
+    } else {
+      stringFree(retired.entries[i].ptr);
     }
-    return collection;
-  });
-
-  s->matchGroup = s->blockCopy(^(const char *regex) {
-    string_collection_t *collection = stringCollection(0, NULL);
-    size_t maxMatches = 100;
-    size_t maxGroups = 100;
-    regex_t regexCompiled;
-    regmatch_t groupArray[maxGroups];
-    unsigned int m;
-    char *cursor;
-    if (regcomp(&regexCompiled, regex, REG_EXTENDED)) {
-      log_err("regcomp() failed");
-    };
-    cursor = (char *)s->value;
-    for (m = 0; m < maxMatches; m++) {
-      if (regexec(&regexCompiled, cursor, maxGroups, groupArray, 0))
-        break; // No more matches
-      unsigned int g = 0;
-      unsigned int offset = 0;
-      for (g = 0; g < maxGroups; g++) {
-        if (groupArray[g].rm_so == (long long)(size_t)-1)
-          break; // No more groups
-        char cursorCopy[strlen(cursor) + 1];
-        strlcpy(cursorCopy, cursor, groupArray[g].rm_eo + 1);
-        if (g == 0) {
-          offset = groupArray[g].rm_eo;
-        } else {
-          char *key = malloc(sizeof(char) *
-                             (groupArray[g].rm_eo - groupArray[g].rm_so + 1));
-          strlcpy(key, cursorCopy + groupArray[g].rm_so,
-                  groupArray[g].rm_eo - groupArray[g].rm_so + 1);
-          string_t *temp = string(key);
-          free(key);
-          collection->push(temp);
-        }
-      }
-      cursor += offset;
+  }
+  retired.count = 0;
+  return count;
+}
+
+/*
+  The intern set is an open-addressing table of string pointers with linear
+  probing. Entries are never removed individually; stringInternFree releases
+  the whole set.
+*/
+static struct {
+  string_t **entries;
+  size_t count;
+  size_t capacity;
+} internSet = {NULL, 0, 0};
+
+static string_t **internFind(string_t **entries, size_t capacity,
+                             const char *str, size_t length, uint32_t hash) {
+  size_t index = hash & (capacity - 1);
+  for (;;) {
+    string_t *entry = entries[index];
+    if (entry == NULL ||
+        (entry->hash == hash && entry->size == length &&
+         memcmp(entry->value, str, length) == 0)) {
+      return &entries[index];
     }
-    regfree(&regexCompiled);
-    return collection;
-  });
+    index = (index + 1) & (capacity - 1);
+  }
+}
 
-  s->free = Block_copy(^(void) {
-    free(s->value);
-    for (int i = 0; i < s->blockCopyCount; i++) {
-      Block_release(s->blockCopies[i].ptr);
+static void internGrow(void) {
+  size_t capacity = internSet.capacity < 64 ? 64 : internSet.capacity * 2;
+  string_t **entries = calloc(capacity, sizeof(string_t *));
+  for (size_t i = 0; i < internSet.capacity; i++) {
+    string_t *entry = internSet.entries[i];
+    if (entry != NULL) {
+      *internFind(entries, capacity, entry->value, entry->size, entry->hash) =
+          entry;
     }
-    Block_release(s->blockCopy);
-    dispatch_async(dispatch_get_main_queue(), ^() {
-      Block_release(s->free);
-      free(s);
-    });
-  });
+  }
+  free(internSet.entries);
+  internSet.entries = entries;
+  internSet.capacity = capacity;
+}
 
-  return s;
+string_t *stringInternWithLength(const char *str, size_t length) {
+  if ((internSet.count + 1) * 4 > internSet.capacity * 3) {
+    internGrow();
+  }
+  uint32_t hash = hashBytes(str, length);
+  string_t **slot =
+      internFind(internSet.entries, internSet.capacity, str, length, hash);
+  if (*slot == NULL) {
+    string_t *s = stringWithLength(NULL, str, length);
+    s->hash = hash;
+    s->flags |= STRING_FLAG_INTERNED;
+    *slot = s;
+    internSet.count++;
+  }
+  return *slot;
+}
+
+string_t *stringIntern(const char *str) {
+  return stringInternWithLength(str, strlen(str));
+}
+
+size_t stringInternCount(void) { return internSet.count; }
+
+void stringInternFree(void) {
+  for (size_t i = 0; i < internSet.capacity; i++) {
+    string_t *entry = internSet.entries[i];
+    if (entry != NULL) {
+      entry->flags &= ~STRING_FLAG_INTERNED;
+      stringFree(entry);
+    }
+  }
+  free(internSet.entries);
+  internSet.entries = NULL;
+  internSet.count = 0;
+  internSet.capacity = 0;
 }
@@ -24,16 +24,18 @@
 #define STRING_H
 
 #include <Block.h>
+#include <arena/arena.h>
 #include <ctype.h>
-#include <dispatch/dispatch.h>
 #include <errno.h>
 #include <limits.h>
 #include <math.h>
 #include <regex.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/uio.h>
 
 #define clean_errno() (errno == 0 ? "None" : strerror(errno))
 
@@ -48,22 +50,69 @@
 #define NUMBER_ERROR_UNSPECIFIED 5
 #define NUMBER_ERROR_ADDITIONAL_CHARACTERS 6
 
-typedef struct malloc_t {
-  void *ptr;
-} malloc_t;
+#define STRING_INLINE_CAPACITY 23
 
-struct string_t;
-struct string_collection_t;
-struct number_t;
+#define STRING_FLAG_INTERNED 1
 
-struct string_t *string(const char *str);
-struct string_collection_t *stringCollection(size_t size,
-                                             struct string_t **arr);
-typedef void (^eachStringCallback)(struct string_t *string);
-typedef void (^eachStringWithIndexCallback)(struct string_t *string, int index);
-typedef void * (^reducerStringCallback)(void *accumulator,
-                                        struct string_t *string);
-typedef void * (^mapStringCallback)(struct string_t *string);
+/*
+  Strings of up to STRING_INLINE_CAPACITY bytes keep their characters in
+  inlineValue and value points at it; longer strings own a heap buffer.
+  Interned strings are shared and must not be mutated or freed.
+
+  A string created with stringInArena allocates from that arena, as do the
+  strings and collections derived from it; stringFree is then a no-op and
+  the memory goes away with arenaReset or arenaFree.
+*/
+typedef struct string_t {
+  char *value;
+  size_t size;
+  size_t capacity;
+  arena_t *arena;
+  uint32_t hash;
+  uint8_t flags;
+  char inlineValue[STRING_INLINE_CAPACITY + 1];
+} string_t;
+
+// A borrowed, non-owning slice of characters; not NUL-terminated.
+typedef struct string_view_t {
+  const char *start;
+  size_t length;
+} string_view_t;
+
+typedef struct string_split_iterator_t {
+  const char *cursor;
+  const char *end;
+  uint64_t delims[4];
+} string_split_iterator_t;
+
+#define STRING_REGEX_CACHE_SIZE 32
+
+/*
+  A compiled extended regular expression. stringMatchGroup compiles through
+  an LRU cache of STRING_REGEX_CACHE_SIZE patterns; callers that reuse a
+  pattern in a hot loop can instead hold their own handle from stringRegex
+  and pass it to stringMatchGroupRegex. stringRegexCached returns the
+  cache's own handle, which stays valid only until it is evicted.
+*/
+typedef struct string_regex_t {
+  char *pattern;
+  regex_t compiled;
+  size_t groups;
+  regmatch_t *matches;
+  int cached;
+} string_regex_t;
+
+typedef struct string_collection_t {
+  size_t size;
+  size_t capacity;
+  string_t **arr;
+  arena_t *arena;
+} string_collection_t;
+
+typedef void (^eachStringCallback)(string_t *string);
+typedef void (^eachStringWithIndexCallback)(string_t *string, int index);
+typedef void * (^reducerStringCallback)(void *accumulator, string_t *string);
+typedef void * (^mapStringCallback)(string_t *string);
 
 typedef struct integer_number_t {
   long long value;
@@ -71,63 +120,131 @@ typedef struct integer_number_t {
 } integer_number_t;
 
 typedef struct decimal_number_t {
-  long double value;
+  double value;
   int error;
 } decimal_number_t;
 
-typedef struct string_collection_t {
-  size_t size;
-  struct string_t **arr;
-  int mallocCount;
-  malloc_t mallocs[1024];
-  void * (^malloc)(size_t size);
-  int blockCopyCount;
-  malloc_t blockCopies[1024];
-  void * (^blockCopy)(void *);
-  void (^each)(eachStringCallback);
-  void (^eachWithIndex)(eachStringWithIndexCallback);
-  void * (^reduce)(void *accumulator, reducerStringCallback);
-  void ** (^map)(mapStringCallback);
-  void (^free)(void);
-  int (^indexOf)(const char *str);
-  struct string_collection_t * (^reverse)(void);
-  struct string_collection_t * (^sort)(void);
-  struct string_collection_t * (^push)(struct string_t *string);
-  struct string_t * (^join)(const char *delim);
-  struct string_t * (^first)();
-  struct string_t * (^second)();
-  struct string_t * (^third)();
-  struct string_t * (^fourth)();
-  struct string_t * (^fifth)();
-  struct string_t * (^last)();
-} string_collection_t;
+/*
+  Strings and collections are plain structs; every operation is a function
+  that takes the receiver first. Creating a string costs one allocation for
+  the struct, plus one for the characters only when they don't fit inline.
+  stringIntern returns one shared string per distinct value, so interned
+  strings can be compared by pointer; they live until stringInternFree.
+*/
 
-typedef struct string_t {
-  char *value;
-  size_t size;
-  int blockCopyCount;
-  malloc_t blockCopies[1024];
-  void * (^blockCopy)(void *);
-  void (^print)(void);
-  struct string_t * (^concat)(const char *str);
-  struct string_t * (^upcase)(void);
-  struct string_t * (^downcase)(void);
-  struct string_t * (^capitalize)(void);
-  struct string_t * (^reverse)(void);
-  struct string_t * (^trim)(void);
-  struct string_t * (^replace)(const char *str1, const char *str2);
-  struct string_t * (^chomp)(void);
-  struct string_t * (^slice)(size_t start, size_t length);
-  struct string_t * (^delete)(const char *str);
-  string_collection_t * (^split)(const char *delim);
-  string_collection_t * (^matchGroup)(const char *regex);
-  int (^indexOf)(const char *str);
-  int (^lastIndexOf)(const char *str);
-  int (^eql)(const char *str);
-  int (^contains)(const char *str);
-  integer_number_t (^toInt)(void);
-  decimal_number_t (^toDecimal)(void);
-  void (^free)(void);
-} string_t;
+string_t *string(const char *str);
+string_t *stringInArena(arena_t *arena, const char *str);
+char *stringErrorMessage(int error);
+
+void stringPrint(string_t *s);
+string_t *stringConcat(string_t *s, const char *str);
+string_t *stringUpcase(string_t *s);
+string_t *stringDowncase(string_t *s);
+string_t *stringCapitalize(string_t *s);
+string_t *stringReverse(string_t *s);
+string_t *stringTrim(string_t *s);
+string_t *stringReplace(string_t *s, const char *str1, const char *str2);
+string_t *stringReplaceAll(string_t *s, const char *str1, const char *str2);
+string_t *stringChomp(string_t *s);
+string_t *stringSlice(string_t *s, size_t start, size_t length);
+string_t *stringDelete(string_t *s, const char *str);
+string_collection_t *stringSplit(string_t *s, const char *delim);
+string_view_t stringView(string_t *s);
+string_t *stringFromView(string_view_t view);
+string_view_t stringViewTrim(string_view_t view);
+int stringViewEql(string_view_t view, const char *str);
+/*
+  Walks the tokens of a string or view without modifying or copying it.
+  Delimiters follow stringSplit: any character of delim separates tokens and
+  empty tokens are skipped.
+
+    string_split_iterator_t it = stringSplitView(s, " ");
+    string_view_t token;
+    while (stringSplitViewNext(&it, &token)) { ... }
+*/
+string_split_iterator_t stringSplitView(string_t *s, const char *delim);
+string_split_iterator_t stringViewSplit(string_view_t view, const char *delim);
+int stringSplitViewNext(string_split_iterator_t *iterator,
+                        string_view_t *token);
+string_collection_t *stringMatchGroup(string_t *s, const char *regex);
+string_collection_t *stringMatchGroupRegex(string_t *s, string_regex_t *regex);
+string_regex_t *stringRegex(const char *pattern);
+void stringRegexFree(string_regex_t *regex);
+string_regex_t *stringRegexCached(const char *pattern);
+size_t stringRegexCacheCount(void);
+void stringRegexCacheFree(void);
+int stringIndexOf(string_t *s, const char *str);
+int stringLastIndexOf(string_t *s, const char *str);
+int stringEql(string_t *s, const char *str);
+int stringEquals(string_t *a, string_t *b);
+uint32_t stringHash(string_t *s);
+int stringContains(string_t *s, const char *str);
+integer_number_t stringToInt(string_t *s);
+decimal_number_t stringToDecimal(string_t *s);
+void stringFree(string_t *s);
+
+/*
+  Base-10 parsers behind stringToInt and stringToDecimal, usable on any
+  span such as a scanner token. Like strtoll/strtod they skip leading
+  whitespace and accept a sign, but they are locale independent and report
+  trailing input as NUMBER_ERROR_ADDITIONAL_CHARACTERS.
+*/
+integer_number_t stringParseInteger(const char *str, size_t length);
+decimal_number_t stringParseDecimal(const char *str, size_t length);
+
+string_t *stringIntern(const char *str);
+string_t *stringInternWithLength(const char *str, size_t length);
+size_t stringInternCount(void);
+void stringInternFree(void);
+
+string_collection_t *stringCollection(size_t size, string_t **arr);
+string_collection_t *stringCollectionInArena(arena_t *arena, size_t size,
+                                             string_t **arr);
+
+void stringCollectionEach(string_collection_t *collection,
+                          eachStringCallback callback);
+void stringCollectionEachWithIndex(string_collection_t *collection,
+                                   eachStringWithIndexCallback callback);
+void *stringCollectionReduce(string_collection_t *collection,
+                             void *accumulator, reducerStringCallback reducer);
+// The returned array is owned by the caller unless the collection lives in
+// an arena.
+void **stringCollectionMap(string_collection_t *collection,
+                           mapStringCallback callback);
+int stringCollectionIndexOf(string_collection_t *collection, const char *str);
+string_collection_t *stringCollectionReverse(string_collection_t *collection);
+string_collection_t *stringCollectionSort(string_collection_t *collection);
+string_collection_t *stringCollectionPush(string_collection_t *collection,
+                                          string_t *string);
+string_collection_t *stringCollectionReserve(string_collection_t *collection,
+                                             size_t capacity);
+string_t *stringCollectionJoin(string_collection_t *collection,
+                               const char *delim);
+
+#define STRING_JOIN_IOV_COUNT 64
+
+// Stream the joined collection without building it in memory. Both return
+// 0 on success and -1 on a write error.
+int stringCollectionJoinToFile(string_collection_t *collection,
+                               const char *delim, FILE *file);
+int stringCollectionJoinToFd(string_collection_t *collection,
+                             const char *delim, int fd);
+string_t *stringCollectionFirst(string_collection_t *collection);
+string_t *stringCollectionSecond(string_collection_t *collection);
+string_t *stringCollectionThird(string_collection_t *collection);
+string_t *stringCollectionFourth(string_collection_t *collection);
+string_t *stringCollectionFifth(string_collection_t *collection);
+string_t *stringCollectionLast(string_collection_t *collection);
+void stringCollectionFree(string_collection_t *collection);
+
+/*
+  stringFree and stringCollectionFree release memory immediately. Code that
+  cannot free a value at the point it dies, such as a REPL that may still
+  print it, can retire it instead; retired values are released together by
+  the next stringReclaim, which returns how many it released.
+*/
+void stringRetire(string_t *s);
+void stringCollectionRetire(string_collection_t *collection);
+size_t stringReclaim(void);
 
 #endif // STRING_H
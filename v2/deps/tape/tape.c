@@ -75,7 +75,7 @@ static string_t *fetch(char *url, char *method, string_collection_t *headers,
   // headers list
   __block struct curl_slist *headersList = NULL;
   if (headers) {
-    headers->each(^(string_t *header) {
+    stringCollectionEach(headers, ^(string_t *header) {
       headersList = curl_slist_append(headersList, header->value);
     });
   }
@@ -318,7 +318,7 @@ testHandler testHandlerFactory(tape_t *root, int level, int ignore,
 
     t->trashableCount = 0;
     t->trash = Block_copy(^(freeHandler freeFn) {
-      t->trashables[t->trashableCount++] = freeFn;
+      t->trashables[t->trashableCount++] = Block_copy(freeFn);
     });
 
     t->ok = ^(char *okName, int condition) {
@@ -334,7 +334,7 @@ testHandler testHandlerFactory(tape_t *root, int level, int ignore,
     };
 
     t->strEqual = ^(char *name, string_t *str1, char *str2) {
-      int isEqual = str1->eql(str2);
+      int isEqual = stringEql(str1, str2);
       t->ok(name, isEqual);
       if (!isEqual) {
         printf("\nExpected: \033[32m\n\n%s\n\n\033[0m", str2);
@@ -372,43 +372,57 @@ testHandler testHandlerFactory(tape_t *root, int level, int ignore,
 
     t->string = ^(char *str) {
       string_t *s = string(str);
-      t->trash(s->free);
+      t->trash(^{
+        stringFree(s);
+      });
       return s;
     };
 
     t->get = ^(char *url) {
       string_t *response = curlGet(url);
-      t->trash(response->free);
+      t->trash(^{
+        stringFree(response);
+      });
       return response;
     };
 
     t->post = ^(char *url, char *data) {
       string_t *response = curlPost(url, data);
-      t->trash(response->free);
+      t->trash(^{
+        stringFree(response);
+      });
       return response;
     };
 
     t->put = ^(char *url, char *data) {
       string_t *response = curlPut(url, data);
-      t->trash(response->free);
+      t->trash(^{
+        stringFree(response);
+      });
       return response;
     };
 
     t->patch = ^(char *url, char *data) {
       string_t *response = curlPatch(url, data);
-      t->trash(response->free);
+      t->trash(^{
+        stringFree(response);
+      });
       return response;
     };
 
     t->delete = ^(char *url) {
       string_t *response = curlDelete(url);
-      t->trash(response->free);
+      t->trash(^{
+        stringFree(response);
+      });
       return response;
     };
 
     t->getHeaders = ^(char *url) {
       string_t *response = curlGetHeaders(url);
-      t->trash(response->free);
+      t->trash(^{
+        stringFree(response);
+      });
       return response;
     };
 
@@ -420,10 +434,14 @@ testHandler testHandlerFactory(tape_t *root, int level, int ignore,
         ^(char *path, char *method, string_collection_t *headers, char *json) {
           char *baseUrl = "http://127.0.0.1:3032";
           string_t *url = string(baseUrl);
-          url->concat(path);
+          stringConcat(url, path);
           string_t *response = fetch(url->value, method, headers, json);
-          t->trash(response->free);
-          t->trash(url->free);
+          t->trash(^{
+            stringFree(response);
+          });
+          t->trash(^{
+            stringFree(url);
+          });
           return response;
         };
 
@@ -448,6 +466,7 @@ testHandler testHandlerFactory(tape_t *root, int level, int ignore,
     /* Cleanup */
     for (int i = 0; i < t->trashableCount; i++) {
       t->trashables[i]();
+      Block_release(t->trashables[i]);
     }
     Block_release(t->trash);
     Block_release(t->test);
@@ -0,0 +1,68 @@
+#include "chunk.h"
+#include <stdlib.h>
+
+void chunk_init(chunk_t *chunk) {
+  chunk->code = NULL;
+  chunk->count = 0;
+  chunk->capacity = 0;
+  chunk->lines = NULL;
+  chunk->line_count = 0;
+  chunk->line_capacity = 0;
+  value_array_init(&chunk->constants);
+}
+
+void chunk_write(chunk_t *chunk, uint8_t byte, int line) {
+  if (chunk->count == chunk->capacity) {
+    chunk->capacity = chunk->capacity < 8 ? 8 : chunk->capacity * 2;
+    chunk->code = realloc(chunk->code, chunk->capacity);
+  }
+  chunk->code[chunk->count] = byte;
+
+  if (chunk->line_count == 0 ||
+      chunk->lines[chunk->line_count - 1].line != line) {
+    if (chunk->line_count == chunk->line_capacity) {
+      chunk->line_capacity =
+          chunk->line_capacity < 8 ? 8 : chunk->line_capacity * 2;
+      chunk->lines =
+          realloc(chunk->lines, chunk->line_capacity * sizeof(line_run_t));
+    }
+    chunk->lines[chunk->line_count++] =
+        (line_run_t){.start = chunk->count, .line = line};
+  }
+  chunk->count++;
+}
+
+size_t chunk_add_constant(chunk_t *chunk, value_t value) {
+  value_array_write(&chunk->constants, value);
+  return chunk->constants.count - 1;
+}
+
+int chunk_get_line(const chunk_t *chunk, size_t offset) {
+  size_t low = 0;
+  size_t high = chunk->line_count;
+  // Find the last run that starts at or before offset.
+  while (high - low > 1) {
+    size_t middle = low + (high - low) / 2;
+    if (chunk->lines[middle].start <= offset) {
+      low = middle;
+    } else {
+      high = middle;
+    }
+  }
+  return chunk->line_count > 0 ? chunk->lines[low].line : 0;
+}
+
+void chunk_truncate(chunk_t *chunk, size_t count) {
+  chunk->count = count;
+  while (chunk->line_count > 0 &&
+         chunk->lines[chunk->line_count - 1].start >= count) {
+    chunk->line_count--;
+  }
+}
+
+void chunk_free(chunk_t *chunk) {
+  free(chunk->code);
+  free(chunk->lines);
+  value_array_free(&chunk->constants);
+  chunk_init(chunk);
+}
@@ -0,0 +1,90 @@
+#ifndef CHUNK_H
+#define CHUNK_H
+
+#include "value.h"
+#include <stdint.h>
+
+// Constant operands are two bytes wide, so a chunk holds this many.
+#define CHUNK_MAX_CONSTANTS 65536
+
+typedef enum op_code_t {
+  OP_CONSTANT,
+  OP_NIL,
+  OP_TRUE,
+  OP_FALSE,
+  OP_POP,
+  OP_GET_LOCAL,
+  OP_SET_LOCAL,
+  OP_GET_GLOBAL,
+  OP_DEFINE_GLOBAL,
+  OP_SET_GLOBAL,
+  OP_GET_UPVALUE,
+  OP_SET_UPVALUE,
+  OP_GET_PROPERTY,
+  OP_SET_PROPERTY,
+  OP_GET_SUPER,
+  OP_EQUAL,
+  OP_GREATER,
+  OP_LESS,
+  OP_ADD,
+  OP_SUBTRACT,
+  OP_MULTIPLY,
+  OP_DIVIDE,
+  OP_NOT,
+  OP_NEGATE,
+  OP_PRINT,
+  OP_JUMP,
+  OP_JUMP_IF_FALSE,
+  OP_LOOP,
+  OP_CALL,
+  OP_INVOKE,
+  OP_SUPER_INVOKE,
+  OP_CLOSURE,
+  OP_CLOSE_UPVALUE,
+  OP_RETURN,
+  OP_CLASS,
+  OP_INHERIT,
+  OP_METHOD,
+  // Superinstructions, emitted by the compiler's peephole in place of the
+  // sequences in their names.
+  OP_ADD_LOCALS,          // GET_LOCAL a, GET_LOCAL b, ADD
+  OP_ADD_CONSTANT,        // CONSTANT k, ADD
+  OP_JUMP_IF_NOT_EQUAL,   // EQUAL, JUMP_IF_FALSE, POP
+  OP_JUMP_IF_NOT_GREATER, // GREATER, JUMP_IF_FALSE, POP
+  OP_JUMP_IF_NOT_LESS,    // LESS, JUMP_IF_FALSE, POP
+  OP_JUMP_IF_EQUAL,       // EQUAL, NOT, JUMP_IF_FALSE, POP
+  OP_JUMP_IF_GREATER,     // GREATER, NOT, JUMP_IF_FALSE, POP
+  OP_JUMP_IF_LESS,        // LESS, NOT, JUMP_IF_FALSE, POP
+} op_code_t;
+
+// The bytes from start up to the next run's start came from line.
+typedef struct line_run_t {
+  size_t start;
+  int line;
+} line_run_t;
+
+/*
+  Bytecode for one function: the instruction stream, its constant pool and
+  a run-length encoded line table, which stores one entry per change of
+  source line instead of one per byte.
+*/
+typedef struct chunk_t {
+  uint8_t *code;
+  size_t count;
+  size_t capacity;
+  line_run_t *lines;
+  size_t line_count;
+  size_t line_capacity;
+  value_array_t constants;
+} chunk_t;
+
+void chunk_init(chunk_t *chunk);
+void chunk_write(chunk_t *chunk, uint8_t byte, int line);
+// Returns the new constant's index.
+size_t chunk_add_constant(chunk_t *chunk, value_t value);
+int chunk_get_line(const chunk_t *chunk, size_t offset);
+// Drops the bytes from count onwards, along with their line runs.
+void chunk_truncate(chunk_t *chunk, size_t count);
+void chunk_free(chunk_t *chunk);
+
+#endif // CHUNK_H
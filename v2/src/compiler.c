@@ -0,0 +1,1109 @@
+#include "compiler.h"
+#include "gc.h"
+#include "vm.h"
+#include <string.h>
+#include <string/string.h>
+
+#define COMPILER_MAX_LOCALS 256
+#define COMPILER_MAX_UPVALUES 256
+#define COMPILER_MAX_ARGUMENTS 255
+#define NO_OP SIZE_MAX
+
+typedef enum precedence_t {
+  PREC_NONE,
+  PREC_ASSIGNMENT, // =
+  PREC_OR,         // or
+  PREC_AND,        // and
+  PREC_EQUALITY,   // == !=
+  PREC_COMPARISON, // < > <= >=
+  PREC_TERM,       // + -
+  PREC_FACTOR,     // * /
+  PREC_UNARY,      // ! -
+  PREC_CALL,       // . ()
+  PREC_PRIMARY,
+} precedence_t;
+
+typedef struct local_t {
+  token_t name;
+  // -1 while the initializer is being compiled.
+  int depth;
+  int is_captured;
+} local_t;
+
+typedef struct upvalue_t {
+  uint8_t index;
+  int is_local;
+} upvalue_t;
+
+typedef enum function_type_t {
+  TYPE_FUNCTION,
+  TYPE_INITIALIZER,
+  TYPE_METHOD,
+  TYPE_SCRIPT,
+} function_type_t;
+
+// Per-function state; enclosing links out to the surrounding function.
+typedef struct compiler_t {
+  struct compiler_t *enclosing;
+  obj_function_t *function;
+  function_type_t type;
+  local_t locals[COMPILER_MAX_LOCALS];
+  int local_count;
+  upvalue_t upvalues[COMPILER_MAX_UPVALUES];
+  int scope_depth;
+  // Where the last two instructions start, or NO_OP, for the peephole.
+  size_t last_op;
+  size_t previous_op;
+  // The latest offset a jump lands on. Instructions before it are never
+  // fused with instructions after it.
+  size_t jump_target;
+} compiler_t;
+
+typedef struct class_compiler_t {
+  struct class_compiler_t *enclosing;
+  int has_superclass;
+} class_compiler_t;
+
+typedef struct parser_t {
+  vm_t *vm;
+  scanner_t *scanner;
+  token_t current;
+  token_t previous;
+  int had_error;
+  int panic_mode;
+  compiler_t *compiler;
+  class_compiler_t *class_compiler;
+} parser_t;
+
+typedef void (*parse_fn_t)(parser_t *parser, int can_assign);
+
+typedef struct parse_rule_t {
+  parse_fn_t prefix;
+  parse_fn_t infix;
+  precedence_t precedence;
+} parse_rule_t;
+
+static chunk_t *current_chunk(parser_t *parser) {
+  return &parser->compiler->function->chunk;
+}
+
+static void error_at(parser_t *parser, token_t *token, const char *message) {
+  if (parser->panic_mode) {
+    return;
+  }
+  parser->panic_mode = 1;
+  fprintf(parser->vm->err, "[line %d] Error", token->line);
+  if (token->type == TOKEN_EOF) {
+    fprintf(parser->vm->err, " at end");
+  } else if (token->type != TOKEN_ERROR) {
+    fprintf(parser->vm->err, " at '%.*s'", (int)token->length, token->start);
+  }
+  fprintf(parser->vm->err, ": %s\n", message);
+  parser->had_error = 1;
+}
+
+static void error(parser_t *parser, const char *message) {
+  error_at(parser, &parser->previous, message);
+}
+
+static void error_at_current(parser_t *parser, const char *message) {
+  error_at(parser, &parser->current, message);
+}
+
+static void advance(parser_t *parser) {
+  parser->previous = parser->current;
+  for (;;) {
+    parser->current = scanner_scan_token(parser->scanner);
+    if (parser->current.type != TOKEN_ERROR) {
+      break;
+    }
+    // Error tokens carry their message in place of a lexeme.
+    char message[64];
+    snprintf(message, sizeof message, "%.*s", (int)parser->current.length,
+             parser->current.start);
+    error_at_current(parser, message);
+  }
+}
+
+static void consume(parser_t *parser, token_type_t type, const char *message) {
+  if (parser->current.type == type) {
+    advance(parser);
+    return;
+  }
+  error_at_current(parser, message);
+}
+
+static int check(parser_t *parser, token_type_t type) {
+  return parser->current.type == type;
+}
+
+static int match(parser_t *parser, token_type_t type) {
+  if (!check(parser, type)) {
+    return 0;
+  }
+  advance(parser);
+  return 1;
+}
+
+static void emit_byte(parser_t *parser, uint8_t byte) {
+  chunk_write(current_chunk(parser), byte, parser->previous.line);
+}
+
+static void emit_bytes(parser_t *parser, uint8_t first, uint8_t second) {
+  emit_byte(parser, first);
+  emit_byte(parser, second);
+}
+
+static void emit_op(parser_t *parser, uint8_t op) {
+  compiler_t *compiler = parser->compiler;
+  compiler->previous_op = compiler->last_op;
+  compiler->last_op = current_chunk(parser)->count;
+  emit_byte(parser, op);
+}
+
+static void emit_short(parser_t *parser, uint16_t operand) {
+  emit_bytes(parser, (operand >> 8) & 0xff, operand & 0xff);
+}
+
+static void emit_loop(parser_t *parser, size_t loop_start) {
+  emit_op(parser, OP_LOOP);
+  size_t offset = current_chunk(parser)->count - loop_start + 2;
+  if (offset > UINT16_MAX) {
+    error(parser, "Loop body too large.");
+  }
+  emit_short(parser, (uint16_t)offset);
+}
+
+// Emits a jump with a placeholder offset and returns where to patch it.
+static size_t emit_jump(parser_t *parser, uint8_t instruction) {
+  emit_op(parser, instruction);
+  emit_short(parser, 0xffff);
+  return current_chunk(parser)->count - 2;
+}
+
+static void emit_return(parser_t *parser) {
+  if (parser->compiler->type == TYPE_INITIALIZER) {
+    emit_op(parser, OP_GET_LOCAL);
+    emit_byte(parser, 0);
+  } else {
+    emit_op(parser, OP_NIL);
+  }
+  emit_op(parser, OP_RETURN);
+}
+
+static uint16_t make_constant(parser_t *parser, value_t value) {
+  gc_write_barrier(parser->vm, &parser->compiler->function->obj, value);
+  size_t constant = chunk_add_constant(current_chunk(parser), value);
+  if (constant >= CHUNK_MAX_CONSTANTS) {
+    error(parser, "Too many constants in one chunk.");
+    return 0;
+  }
+  return (uint16_t)constant;
+}
+
+static void emit_constant(parser_t *parser, value_t value) {
+  emit_op(parser, OP_CONSTANT);
+  emit_short(parser, make_constant(parser, value));
+}
+
+static void patch_jump(parser_t *parser, size_t offset) {
+  chunk_t *chunk = current_chunk(parser);
+  // -2 to adjust for the bytecode for the jump offset itself.
+  size_t jump = chunk->count - offset - 2;
+  if (jump > UINT16_MAX) {
+    error(parser, "Too much code to jump over.");
+  }
+  chunk->code[offset] = (jump >> 8) & 0xff;
+  chunk->code[offset + 1] = jump & 0xff;
+  parser->compiler->jump_target = chunk->count;
+}
+
+// Returns the current offset as the target of a later backward jump.
+static size_t loop_target(parser_t *parser) {
+  size_t offset = current_chunk(parser)->count;
+  parser->compiler->jump_target = offset;
+  return offset;
+}
+
+/*
+  The peephole. Fusion happens as instructions are emitted: before emitting
+  ADD or a condition jump, the compiler looks back at the instructions it
+  just wrote and rewrites them into one superinstruction. The group may
+  only be rewritten when no jump lands past its first instruction.
+*/
+static int fusible(parser_t *parser, size_t start) {
+#ifdef COMPILER_NO_PEEPHOLE
+  (void)parser;
+  (void)start;
+  return 0;
+#else
+  return start != NO_OP && start >= parser->compiler->jump_target;
+#endif
+}
+
+static void emit_add(parser_t *parser) {
+  compiler_t *compiler = parser->compiler;
+  chunk_t *chunk = current_chunk(parser);
+  size_t last = compiler->last_op;
+  size_t previous = compiler->previous_op;
+  if (fusible(parser, previous) && chunk->code[previous] == OP_GET_LOCAL &&
+      chunk->code[last] == OP_GET_LOCAL) {
+    chunk->code[previous] = OP_ADD_LOCALS;
+    chunk->code[previous + 2] = chunk->code[last + 1];
+    chunk_truncate(chunk, previous + 3);
+    compiler->last_op = previous;
+    compiler->previous_op = NO_OP;
+    return;
+  }
+  if (fusible(parser, last) && chunk->code[last] == OP_CONSTANT) {
+    chunk->code[last] = OP_ADD_CONSTANT;
+    return;
+  }
+  emit_op(parser, OP_ADD);
+}
+
+// The compare-and-branch for op, or OP_JUMP_IF_FALSE if op isn't one.
+static uint8_t compare_jump(uint8_t op, int negated) {
+  switch (op) {
+  case OP_EQUAL:
+    return negated ? OP_JUMP_IF_EQUAL : OP_JUMP_IF_NOT_EQUAL;
+  case OP_GREATER:
+    return negated ? OP_JUMP_IF_GREATER : OP_JUMP_IF_NOT_GREATER;
+  case OP_LESS:
+    return negated ? OP_JUMP_IF_LESS : OP_JUMP_IF_NOT_LESS;
+  default:
+    return OP_JUMP_IF_FALSE;
+  }
+}
+
+/*
+  Emits the jump out of an if or loop condition. When the condition ends in
+  a comparison the two fuse into a compare-and-branch that pops its
+  operands, so *fused is set and there is no condition value for the
+  caller to pop on either path.
+*/
+static size_t emit_condition_jump(parser_t *parser, int *fused) {
+  compiler_t *compiler = parser->compiler;
+  chunk_t *chunk = current_chunk(parser);
+  size_t compare = compiler->last_op;
+  int negated = 0;
+  if (fusible(parser, compiler->previous_op) &&
+      chunk->code[compare] == OP_NOT) {
+    compare = compiler->previous_op;
+    negated = 1;
+  }
+  uint8_t jump = OP_JUMP_IF_FALSE;
+  if (fusible(parser, compare)) {
+    jump = compare_jump(chunk->code[compare], negated);
+  }
+  *fused = jump != OP_JUMP_IF_FALSE;
+  if (*fused) {
+    chunk_truncate(chunk, compare);
+    compiler->last_op = compiler->previous_op = NO_OP;
+  }
+  return emit_jump(parser, jump);
+}
+
+static void init_compiler(parser_t *parser, compiler_t *compiler,
+                          function_type_t type) {
+  compiler->enclosing = parser->compiler;
+  compiler->function = NULL;
+  compiler->type = type;
+  compiler->local_count = 0;
+  compiler->scope_depth = 0;
+  compiler->last_op = NO_OP;
+  compiler->previous_op = NO_OP;
+  compiler->jump_target = 0;
+  // Linked in before allocating so a collection can see the new function
+  // as soon as it exists.
+  parser->compiler = compiler;
+  parser->vm->compiler = compiler;
+  compiler->function = object_new_function(parser->vm);
+  if (type != TYPE_SCRIPT) {
+    obj_string_t *name = object_copy_string(
+        parser->vm, parser->previous.start, parser->previous.length);
+    gc_write_barrier(parser->vm, &compiler->function->obj, value_obj(name));
+    compiler->function->name = name;
+  }
+
+  // Slot zero holds the function being called, or this inside methods.
+  local_t *local = &compiler->locals[compiler->local_count++];
+  local->depth = 0;
+  local->is_captured = 0;
+  if (type != TYPE_FUNCTION) {
+    local->name.start = "this";
+    local->name.length = 4;
+  } else {
+    local->name.start = "";
+    local->name.length = 0;
+  }
+}
+
+static obj_function_t *end_compiler(parser_t *parser) {
+  emit_return(parser);
+  obj_function_t *function = parser->compiler->function;
+  parser->compiler = parser->compiler->enclosing;
+  parser->vm->compiler = parser->compiler;
+  return function;
+}
+
+static void begin_scope(parser_t *parser) { parser->compiler->scope_depth++; }
+
+static void end_scope(parser_t *parser) {
+  compiler_t *compiler = parser->compiler;
+  compiler->scope_depth--;
+  while (compiler->local_count > 0 &&
+         compiler->locals[compiler->local_count - 1].depth >
+             compiler->scope_depth) {
+    if (compiler->locals[compiler->local_count - 1].is_captured) {
+      emit_op(parser, OP_CLOSE_UPVALUE);
+    } else {
+      emit_op(parser, OP_POP);
+    }
+    compiler->local_count--;
+  }
+}
+
+static void expression(parser_t *parser);
+static void statement(parser_t *parser);
+static void declaration(parser_t *parser);
+static parse_rule_t *get_rule(token_type_t type);
+static void parse_precedence(parser_t *parser, precedence_t precedence);
+
+static uint16_t identifier_constant(parser_t *parser, token_t *name) {
+  return make_constant(parser, value_obj(object_copy_string(
+                                   parser->vm, name->start, name->length)));
+}
+
+static int identifiers_equal(token_t *a, token_t *b) {
+  return a->length == b->length && memcmp(a->start, b->start, a->length) == 0;
+}
+
+static int resolve_local(parser_t *parser, compiler_t *compiler,
+                         token_t *name) {
+  for (int i = compiler->local_count - 1; i >= 0; i--) {
+    local_t *local = &compiler->locals[i];
+    if (identifiers_equal(name, &local->name)) {
+      if (local->depth == -1) {
+        error(parser, "Can't read local variable in its own initializer.");
+      }
+      return i;
+    }
+  }
+  return -1;
+}
+
+static int add_upvalue(parser_t *parser, compiler_t *compiler, uint8_t index,
+                       int is_local) {
+  int upvalue_count = compiler->function->upvalue_count;
+  for (int i = 0; i < upvalue_count; i++) {
+    upvalue_t *upvalue = &compiler->upvalues[i];
+    if (upvalue->index == index && upvalue->is_local == is_local) {
+      return i;
+    }
+  }
+  if (upvalue_count == COMPILER_MAX_UPVALUES) {
+    error(parser, "Too many closure variables in function.");
+    return 0;
+  }
+  compiler->upvalues[upvalue_count].is_local = is_local;
+  compiler->upvalues[upvalue_count].index = index;
+  return compiler->function->upvalue_count++;
+}
+
+static int resolve_upvalue(parser_t *parser, compiler_t *compiler,
+                           token_t *name) {
+  if (compiler->enclosing == NULL) {
+    return -1;
+  }
+  int local = resolve_local(parser, compiler->enclosing, name);
+  if (local != -1) {
+    compiler->enclosing->locals[local].is_captured = 1;
+    return add_upvalue(parser, compiler, (uint8_t)local, 1);
+  }
+  int upvalue = resolve_upvalue(parser, compiler->enclosing, name);
+  if (upvalue != -1) {
+    return add_upvalue(parser, compiler, (uint8_t)upvalue, 0);
+  }
+  return -1;
+}
+
+static void add_local(parser_t *parser, token_t name) {
+  compiler_t *compiler = parser->compiler;
+  if (compiler->local_count == COMPILER_MAX_LOCALS) {
+    error(parser, "Too many local variables in function.");
+    return;
+  }
+  local_t *local = &compiler->locals[compiler->local_count++];
+  local->name = name;
+  local->depth = -1;
+  local->is_captured = 0;
+}
+
+static void declare_variable(parser_t *parser) {
+  compiler_t *compiler = parser->compiler;
+  if (compiler->scope_depth == 0) {
+    return;
+  }
+  token_t *name = &parser->previous;
+  for (int i = compiler->local_count - 1; i >= 0; i--) {
+    local_t *local = &compiler->locals[i];
+    if (local->depth != -1 && local->depth < compiler->scope_depth) {
+      break;
+    }
+    if (identifiers_equal(name, &local->name)) {
+      error(parser, "Already a variable with this name in this scope.");
+    }
+  }
+  add_local(parser, *name);
+}
+
+static uint16_t parse_variable(parser_t *parser, const char *message) {
+  consume(parser, TOKEN_IDENTIFIER, message);
+  declare_variable(parser);
+  if (parser->compiler->scope_depth > 0) {
+    return 0;
+  }
+  return identifier_constant(parser, &parser->previous);
+}
+
+static void mark_initialized(parser_t *parser) {
+  compiler_t *compiler = parser->compiler;
+  if (compiler->scope_depth == 0) {
+    return;
+  }
+  compiler->locals[compiler->local_count - 1].depth = compiler->scope_depth;
+}
+
+static void define_variable(parser_t *parser, uint16_t global) {
+  if (parser->compiler->scope_depth > 0) {
+    mark_initialized(parser);
+    return;
+  }
+  emit_op(parser, OP_DEFINE_GLOBAL);
+  emit_short(parser, global);
+}
+
+static uint8_t argument_list(parser_t *parser) {
+  int arg_count = 0;
+  if (!check(parser, TOKEN_RIGHT_PAREN)) {
+    do {
+      expression(parser);
+      if (arg_count == COMPILER_MAX_ARGUMENTS) {
+        error(parser, "Can't have more than 255 arguments.");
+      }
+      arg_count++;
+    } while (match(parser, TOKEN_COMMA));
+  }
+  consume(parser, TOKEN_RIGHT_PAREN, "Expect ')' after arguments.");
+  return (uint8_t)arg_count;
+}
+
+static void and_(parser_t *parser, int can_assign) {
+  (void)can_assign;
+  size_t end_jump = emit_jump(parser, OP_JUMP_IF_FALSE);
+  emit_op(parser, OP_POP);
+  parse_precedence(parser, PREC_AND);
+  patch_jump(parser, end_jump);
+}
+
+static void binary(parser_t *parser, int can_assign) {
+  (void)can_assign;
+  token_type_t operator_type = parser->previous.type;
+  parse_rule_t *rule = get_rule(operator_type);
+  parse_precedence(parser, (precedence_t)(rule->precedence + 1));
+
+  switch (operator_type) {
+  case TOKEN_BANG_EQUAL:
+    emit_op(parser, OP_EQUAL);
+    emit_op(parser, OP_NOT);
+    break;
+  case TOKEN_EQUAL_EQUAL:
+    emit_op(parser, OP_EQUAL);
+    break;
+  case TOKEN_GREATER:
+    emit_op(parser, OP_GREATER);
+    break;
+  case TOKEN_GREATER_EQUAL:
+    emit_op(parser, OP_LESS);
+    emit_op(parser, OP_NOT);
+    break;
+  case TOKEN_LESS:
+    emit_op(parser, OP_LESS);
+    break;
+  case TOKEN_LESS_EQUAL:
+    emit_op(parser, OP_GREATER);
+    emit_op(parser, OP_NOT);
+    break;
+  case TOKEN_PLUS:
+    emit_add(parser);
+    break;
+  case TOKEN_MINUS:
+    emit_op(parser, OP_SUBTRACT);
+    break;
+  case TOKEN_STAR:
+    emit_op(parser, OP_MULTIPLY);
+    break;
+  case TOKEN_SLASH:
+    emit_op(parser, OP_DIVIDE);
+    break;
+  default:
+    return;
+  }
+}
+
+static void call(parser_t *parser, int can_assign) {
+  (void)can_assign;
+  uint8_t arg_count = argument_list(parser);
+  emit_op(parser, OP_CALL);
+  emit_byte(parser, arg_count);
+}
+
+static void dot(parser_t *parser, int can_assign) {
+  consume(parser, TOKEN_IDENTIFIER, "Expect property name after '.'.");
+  uint16_t name = identifier_constant(parser, &parser->previous);
+
+  if (can_assign && match(parser, TOKEN_EQUAL)) {
+    expression(parser);
+    emit_op(parser, OP_SET_PROPERTY);
+    emit_short(parser, name);
+  } else if (match(parser, TOKEN_LEFT_PAREN)) {
+    uint8_t arg_count = argument_list(parser);
+    emit_op(parser, OP_INVOKE);
+    emit_short(parser, name);
+    emit_byte(parser, arg_count);
+  } else {
+    emit_op(parser, OP_GET_PROPERTY);
+    emit_short(parser, name);
+  }
+}
+
+static void literal(parser_t *parser, int can_assign) {
+  (void)can_assign;
+  switch (parser->previous.type) {
+  case TOKEN_FALSE:
+    emit_op(parser, OP_FALSE);
+    break;
+  case TOKEN_NIL:
+    emit_op(parser, OP_NIL);
+    break;
+  case TOKEN_TRUE:
+    emit_op(parser, OP_TRUE);
+    break;
+  default:
+    return;
+  }
+}
+
+static void grouping(parser_t *parser, int can_assign) {
+  (void)can_assign;
+  expression(parser);
+  consume(parser, TOKEN_RIGHT_PAREN, "Expect ')' after expression.");
+}
+
+static void number(parser_t *parser, int can_assign) {
+  (void)can_assign;
+  decimal_number_t number =
+      stringParseDecimal(parser->previous.start, parser->previous.length);
+  if (number.error) {
+    error(parser, "Number literal out of range.");
+  }
+  emit_constant(parser, value_number(number.value));
+}
+
+static void or_(parser_t *parser, int can_assign) {
+  (void)can_assign;
+  size_t else_jump = emit_jump(parser, OP_JUMP_IF_FALSE);
+  size_t end_jump = emit_jump(parser, OP_JUMP);
+  patch_jump(parser, else_jump);
+  emit_op(parser, OP_POP);
+  parse_precedence(parser, PREC_OR);
+  patch_jump(parser, end_jump);
+}
+
+static void string_(parser_t *parser, int can_assign) {
+  (void)can_assign;
+  // Trim the surrounding quotes.
+  emit_constant(parser, value_obj(object_copy_string(
+                            parser->vm, parser->previous.start + 1,
+                            parser->previous.length - 2)));
+}
+
+static void named_variable(parser_t *parser, token_t name, int can_assign) {
+  uint8_t get_op;
+  uint8_t set_op;
+  int wide = 0;
+  int arg = resolve_local(parser, parser->compiler, &name);
+  if (arg != -1) {
+    get_op = OP_GET_LOCAL;
+    set_op = OP_SET_LOCAL;
+  } else if ((arg = resolve_upvalue(parser, parser->compiler, &name)) != -1) {
+    get_op = OP_GET_UPVALUE;
+    set_op = OP_SET_UPVALUE;
+  } else {
+    arg = identifier_constant(parser, &name);
+    get_op = OP_GET_GLOBAL;
+    set_op = OP_SET_GLOBAL;
+    wide = 1;
+  }
+
+  if (can_assign && match(parser, TOKEN_EQUAL)) {
+    expression(parser);
+    emit_op(parser, set_op);
+  } else {
+    emit_op(parser, get_op);
+  }
+  if (wide) {
+    emit_short(parser, (uint16_t)arg);
+  } else {
+    emit_byte(parser, (uint8_t)arg);
+  }
+}
+
+static void variable(parser_t *parser, int can_assign) {
+  named_variable(parser, parser->previous, can_assign);
+}
+
+static token_t synthetic_token(const char *text) {
+  return (token_t){.type = TOKEN_IDENTIFIER,
+                   .line = 0,
+                   .start = text,
+                   .length = strlen(text)};
+}
+
+static void super_(parser_t *parser, int can_assign) {
+  (void)can_assign;
+  if (parser->class_compiler == NULL) {
+    error(parser, "Can't use 'super' outside of a class.");
+  } else if (!parser->class_compiler->has_superclass) {
+    error(parser, "Can't use 'super' in a class with no superclass.");
+  }
+
+  consume(parser, TOKEN_DOT, "Expect '.' after 'super'.");
+  consume(parser, TOKEN_IDENTIFIER, "Expect superclass method name.");
+  uint16_t name = identifier_constant(parser, &parser->previous);
+
+  named_variable(parser, synthetic_token("this"), 0);
+  if (match(parser, TOKEN_LEFT_PAREN)) {
+    uint8_t arg_count = argument_list(parser);
+    named_variable(parser, synthetic_token("super"), 0);
+    emit_op(parser, OP_SUPER_INVOKE);
+    emit_short(parser, name);
+    emit_byte(parser, arg_count);
+  } else {
+    named_variable(parser, synthetic_token("super"), 0);
+    emit_op(parser, OP_GET_SUPER);
+    emit_short(parser, name);
+  }
+}
+
+static void this_(parser_t *parser, int can_assign) {
+  (void)can_assign;
+  if (parser->class_compiler == NULL) {
+    error(parser, "Can't use 'this' outside of a class.");
+    return;
+  }
+  variable(parser, 0);
+}
+
+static void unary(parser_t *parser, int can_assign) {
+  (void)can_assign;
+  token_type_t operator_type = parser->previous.type;
+  parse_precedence(parser, PREC_UNARY);
+  switch (operator_type) {
+  case TOKEN_BANG:
+    emit_op(parser, OP_NOT);
+    break;
+  case TOKEN_MINUS:
+    emit_op(parser, OP_NEGATE);
+    break;
+  default:
+    return;
+  }
+}
+
+static parse_rule_t rules[] = {
+    [TOKEN_LEFT_PAREN] = {grouping, call, PREC_CALL},
+    [TOKEN_RIGHT_PAREN] = {NULL, NULL, PREC_NONE},
+    [TOKEN_LEFT_BRACE] = {NULL, NULL, PREC_NONE},
+    [TOKEN_RIGHT_BRACE] = {NULL, NULL, PREC_NONE},
+    [TOKEN_COMMA] = {NULL, NULL, PREC_NONE},
+    [TOKEN_DOT] = {NULL, dot, PREC_CALL},
+    [TOKEN_MINUS] = {unary, binary, PREC_TERM},
+    [TOKEN_PLUS] = {NULL, binary, PREC_TERM},
+    [TOKEN_SEMICOLON] = {NULL, NULL, PREC_NONE},
+    [TOKEN_SLASH] = {NULL, binary, PREC_FACTOR},
+    [TOKEN_STAR] = {NULL, binary, PREC_FACTOR},
+    [TOKEN_BANG] = {unary, NULL, PREC_NONE},
+    [TOKEN_BANG_EQUAL] = {NULL, binary, PREC_EQUALITY},
+    [TOKEN_EQUAL] = {NULL, NULL, PREC_NONE},
+    [TOKEN_EQUAL_EQUAL] = {NULL, binary, PREC_EQUALITY},
+    [TOKEN_GREATER] = {NULL, binary, PREC_COMPARISON},
+    [TOKEN_GREATER_EQUAL] = {NULL, binary, PREC_COMPARISON},
+    [TOKEN_LESS] = {NULL, binary, PREC_COMPARISON},
+    [TOKEN_LESS_EQUAL] = {NULL, binary, PREC_COMPARISON},
+    [TOKEN_IDENTIFIER] = {variable, NULL, PREC_NONE},
+    [TOKEN_STRING] = {string_, NULL, PREC_NONE},
+    [TOKEN_NUMBER] = {number, NULL, PREC_NONE},
+    [TOKEN_AND] = {NULL, and_, PREC_AND},
+    [TOKEN_CLASS] = {NULL, NULL, PREC_NONE},
+    [TOKEN_ELSE] = {NULL, NULL, PREC_NONE},
+    [TOKEN_FALSE] = {literal, NULL, PREC_NONE},
+    [TOKEN_FOR] = {NULL, NULL, PREC_NONE},
+    [TOKEN_FUN] = {NULL, NULL, PREC_NONE},
+    [TOKEN_IF] = {NULL, NULL, PREC_NONE},
+    [TOKEN_NIL] = {literal, NULL, PREC_NONE},
+    [TOKEN_OR] = {NULL, or_, PREC_OR},
+    [TOKEN_PRINT] = {NULL, NULL, PREC_NONE},
+    [TOKEN_RETURN] = {NULL, NULL, PREC_NONE},
+    [TOKEN_SUPER] = {super_, NULL, PREC_NONE},
+    [TOKEN_THIS] = {this_, NULL, PREC_NONE},
+    [TOKEN_TRUE] = {literal, NULL, PREC_NONE},
+    [TOKEN_VAR] = {NULL, NULL, PREC_NONE},
+    [TOKEN_WHILE] = {NULL, NULL, PREC_NONE},
+    [TOKEN_ERROR] = {NULL, NULL, PREC_NONE},
+    [TOKEN_EOF] = {NULL, NULL, PREC_NONE},
+};
+
+static parse_rule_t *get_rule(token_type_t type) { return &rules[type]; }
+
+static void parse_precedence(parser_t *parser, precedence_t precedence) {
+  advance(parser);
+  parse_fn_t prefix_rule = get_rule(parser->previous.type)->prefix;
+  if (prefix_rule == NULL) {
+    error(parser, "Expect expression.");
+    return;
+  }
+
+  int can_assign = precedence <= PREC_ASSIGNMENT;
+  prefix_rule(parser, can_assign);
+
+  while (precedence <= get_rule(parser->current.type)->precedence) {
+    advance(parser);
+    get_rule(parser->previous.type)->infix(parser, can_assign);
+  }
+
+  if (can_assign && match(parser, TOKEN_EQUAL)) {
+    error(parser, "Invalid assignment target.");
+  }
+}
+
+static void expression(parser_t *parser) {
+  parse_precedence(parser, PREC_ASSIGNMENT);
+}
+
+static void block(parser_t *parser) {
+  while (!check(parser, TOKEN_RIGHT_BRACE) && !check(parser, TOKEN_EOF)) {
+    declaration(parser);
+  }
+  consume(parser, TOKEN_RIGHT_BRACE, "Expect '}' after block.");
+}
+
+static void function(parser_t *parser, function_type_t type) {
+  compiler_t compiler;
+  init_compiler(parser, &compiler, type);
+  begin_scope(parser);
+
+  consume(parser, TOKEN_LEFT_PAREN, "Expect '(' after function name.");
+  if (!check(parser, TOKEN_RIGHT_PAREN)) {
+    do {
+      compiler.function->arity++;
+      if (compiler.function->arity > COMPILER_MAX_ARGUMENTS) {
+        error_at_current(parser, "Can't have more than 255 parameters.");
+      }
+      uint16_t constant = parse_variable(parser, "Expect parameter name.");
+      define_variable(parser, constant);
+    } while (match(parser, TOKEN_COMMA));
+  }
+  consume(parser, TOKEN_RIGHT_PAREN, "Expect ')' after parameters.");
+  consume(parser, TOKEN_LEFT_BRACE, "Expect '{' before function body.");
+  block(parser);
+
+  obj_function_t *function = end_compiler(parser);
+  emit_op(parser, OP_CLOSURE);
+  emit_short(parser, make_constant(parser, value_obj(function)));
+  for (int i = 0; i < function->upvalue_count; i++) {
+    emit_byte(parser, compiler.upvalues[i].is_local ? 1 : 0);
+    emit_byte(parser, compiler.upvalues[i].index);
+  }
+}
+
+static void method(parser_t *parser) {
+  consume(parser, TOKEN_IDENTIFIER, "Expect method name.");
+  uint16_t constant = identifier_constant(parser, &parser->previous);
+  function_type_t type = TYPE_METHOD;
+  if (parser->previous.length == 4 &&
+      memcmp(parser->previous.start, "init", 4) == 0) {
+    type = TYPE_INITIALIZER;
+  }
+  function(parser, type);
+  emit_op(parser, OP_METHOD);
+  emit_short(parser, constant);
+}
+
+static void class_declaration(parser_t *parser) {
+  consume(parser, TOKEN_IDENTIFIER, "Expect class name.");
+  token_t class_name = parser->previous;
+  uint16_t name_constant = identifier_constant(parser, &parser->previous);
+  declare_variable(parser);
+
+  emit_op(parser, OP_CLASS);
+  emit_short(parser, name_constant);
+  define_variable(parser, name_constant);
+
+  class_compiler_t class_compiler = {.enclosing = parser->class_compiler,
+                                     .has_superclass = 0};
+  parser->class_compiler = &class_compiler;
+
+  if (match(parser, TOKEN_LESS)) {
+    consume(parser, TOKEN_IDENTIFIER, "Expect superclass name.");
+    variable(parser, 0);
+    if (identifiers_equal(&class_name, &parser->previous)) {
+      error(parser, "A class can't inherit from itself.");
+    }
+
+    begin_scope(parser);
+    add_local(parser, synthetic_token("super"));
+    define_variable(parser, 0);
+
+    named_variable(parser, class_name, 0);
+    emit_op(parser, OP_INHERIT);
+    class_compiler.has_superclass = 1;
+  }
+
+  named_variable(parser, class_name, 0);
+  consume(parser, TOKEN_LEFT_BRACE, "Expect '{' before class body.");
+  while (!check(parser, TOKEN_RIGHT_BRACE) && !check(parser, TOKEN_EOF)) {
+    method(parser);
+  }
+  consume(parser, TOKEN_RIGHT_BRACE, "Expect '}' after class body.");
+  emit_op(parser, OP_POP);
+
+  if (class_compiler.has_superclass) {
+    end_scope(parser);
+  }
+  parser->class_compiler = parser->class_compiler->enclosing;
+}
+
+static void fun_declaration(parser_t *parser) {
+  uint16_t global = parse_variable(parser, "Expect function name.");
+  mark_initialized(parser);
+  function(parser, TYPE_FUNCTION);
+  define_variable(parser, global);
+}
+
+static void var_declaration(parser_t *parser) {
+  uint16_t global = parse_variable(parser, "Expect variable name.");
+  if (match(parser, TOKEN_EQUAL)) {
+    expression(parser);
+  } else {
+    emit_op(parser, OP_NIL);
+  }
+  consume(parser, TOKEN_SEMICOLON, "Expect ';' after variable declaration.");
+  define_variable(parser, global);
+}
+
+static void expression_statement(parser_t *parser) {
+  expression(parser);
+  consume(parser, TOKEN_SEMICOLON, "Expect ';' after expression.");
+  emit_op(parser, OP_POP);
+}
+
+static void for_statement(parser_t *parser) {
+  begin_scope(parser);
+  consume(parser, TOKEN_LEFT_PAREN, "Expect '(' after 'for'.");
+  if (match(parser, TOKEN_SEMICOLON)) {
+    // No initializer.
+  } else if (match(parser, TOKEN_VAR)) {
+    var_declaration(parser);
+  } else {
+    expression_statement(parser);
+  }
+
+  size_t loop_start = loop_target(parser);
+  size_t exit_jump = 0;
+  int has_condition = 0;
+  int fused = 0;
+  if (!match(parser, TOKEN_SEMICOLON)) {
+    expression(parser);
+    consume(parser, TOKEN_SEMICOLON, "Expect ';' after loop condition.");
+    exit_jump = emit_condition_jump(parser, &fused);
+    has_condition = 1;
+    if (!fused) {
+      emit_op(parser, OP_POP);
+    }
+  }
+
+  if (!match(parser, TOKEN_RIGHT_PAREN)) {
+    size_t body_jump = emit_jump(parser, OP_JUMP);
+    size_t increment_start = loop_target(parser);
+    expression(parser);
+    emit_op(parser, OP_POP);
+    consume(parser, TOKEN_RIGHT_PAREN, "Expect ')' after for clauses.");
+
+    emit_loop(parser, loop_start);
+    loop_start = increment_start;
+    patch_jump(parser, body_jump);
+  }
+
+  statement(parser);
+  emit_loop(parser, loop_start);
+
+  if (has_condition) {
+    patch_jump(parser, exit_jump);
+    if (!fused) {
+      emit_op(parser, OP_POP);
+    }
+  }
+  end_scope(parser);
+}
+
+static void if_statement(parser_t *parser) {
+  consume(parser, TOKEN_LEFT_PAREN, "Expect '(' after 'if'.");
+  expression(parser);
+  consume(parser, TOKEN_RIGHT_PAREN, "Expect ')' after condition.");
+
+  int fused;
+  size_t then_jump = emit_condition_jump(parser, &fused);
+  if (!fused) {
+    emit_op(parser, OP_POP);
+  }
+  statement(parser);
+
+  size_t else_jump = emit_jump(parser, OP_JUMP);
+  patch_jump(parser, then_jump);
+  if (!fused) {
+    emit_op(parser, OP_POP);
+  }
+
+  if (match(parser, TOKEN_ELSE)) {
+    statement(parser);
+  }
+  patch_jump(parser, else_jump);
+}
+
+static void print_statement(parser_t *parser) {
+  expression(parser);
+  consume(parser, TOKEN_SEMICOLON, "Expect ';' after value.");
+  emit_op(parser, OP_PRINT);
+}
+
+static void return_statement(parser_t *parser) {
+  if (parser->compiler->type == TYPE_SCRIPT) {
+    error(parser, "Can't return from top-level code.");
+  }
+  if (match(parser, TOKEN_SEMICOLON)) {
+    emit_return(parser);
+    return;
+  }
+  if (parser->compiler->type == TYPE_INITIALIZER) {
+    error(parser, "Can't return a value from an initializer.");
+  }
+  expression(parser);
+  consume(parser, TOKEN_SEMICOLON, "Expect ';' after return value.");
+  emit_op(parser, OP_RETURN);
+}
+
+static void while_statement(parser_t *parser) {
+  size_t loop_start = loop_target(parser);
+  consume(parser, TOKEN_LEFT_PAREN, "Expect '(' after 'while'.");
+  expression(parser);
+  consume(parser, TOKEN_RIGHT_PAREN, "Expect ')' after condition.");
+
+  int fused;
+  size_t exit_jump = emit_condition_jump(parser, &fused);
+  if (!fused) {
+    emit_op(parser, OP_POP);
+  }
+  statement(parser);
+  emit_loop(parser, loop_start);
+
+  patch_jump(parser, exit_jump);
+  if (!fused) {
+    emit_op(parser, OP_POP);
+  }
+}
+
+// Skips to a statement boundary so one mistake reports one error.
+static void synchronize(parser_t *parser) {
+  parser->panic_mode = 0;
+  while (parser->current.type != TOKEN_EOF) {
+    if (parser->previous.type == TOKEN_SEMICOLON) {
+      return;
+    }
+    switch (parser->current.type) {
+    case TOKEN_CLASS:
+    case TOKEN_FUN:
+    case TOKEN_VAR:
+    case TOKEN_FOR:
+    case TOKEN_IF:
+    case TOKEN_WHILE:
+    case TOKEN_PRINT:
+    case TOKEN_RETURN:
+      return;
+    default:
+      advance(parser);
+    }
+  }
+}
+
+static void declaration(parser_t *parser) {
+  if (match(parser, TOKEN_CLASS)) {
+    class_declaration(parser);
+  } else if (match(parser, TOKEN_FUN)) {
+    fun_declaration(parser);
+  } else if (match(parser, TOKEN_VAR)) {
+    var_declaration(parser);
+  } else {
+    statement(parser);
+  }
+  if (parser->panic_mode) {
+    synchronize(parser);
+  }
+}
+
+static void statement(parser_t *parser) {
+  if (match(parser, TOKEN_PRINT)) {
+    print_statement(parser);
+  } else if (match(parser, TOKEN_FOR)) {
+    for_statement(parser);
+  } else if (match(parser, TOKEN_IF)) {
+    if_statement(parser);
+  } else if (match(parser, TOKEN_RETURN)) {
+    return_statement(parser);
+  } else if (match(parser, TOKEN_WHILE)) {
+    while_statement(parser);
+  } else if (match(parser, TOKEN_LEFT_BRACE)) {
+    begin_scope(parser);
+    block(parser);
+    end_scope(parser);
+  } else {
+    expression_statement(parser);
+  }
+}
+
+obj_function_t *compiler_compile(vm_t *vm, scanner_t *scanner) {
+  parser_t parser = {.vm = vm,
+                     .scanner = scanner,
+                     .had_error = 0,
+                     .panic_mode = 0,
+                     .compiler = NULL,
+                     .class_compiler = NULL};
+  compiler_t compiler;
+  init_compiler(&parser, &compiler, TYPE_SCRIPT);
+
+  advance(&parser);
+  while (!match(&parser, TOKEN_EOF)) {
+    declaration(&parser);
+  }
+
+  obj_function_t *function = end_compiler(&parser);
+  return parser.had_error ? NULL : function;
+}
+
+void compiler_mark_roots(vm_t *vm) {
+  for (compiler_t *compiler = vm->compiler; compiler != NULL;
+       compiler = compiler->enclosing) {
+    gc_mark_object(vm, (obj_t *)compiler->function);
+  }
+}
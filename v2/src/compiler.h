@@ -0,0 +1,17 @@
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include "object.h"
+#include "scanner.h"
+
+/*
+  Single-pass Pratt compiler: pulls tokens from the scanner on demand and
+  emits bytecode as it parses, with no syntax tree in between. Returns the
+  top-level script function, or NULL once errors have been reported to
+  vm->err.
+*/
+obj_function_t *compiler_compile(vm_t *vm, scanner_t *scanner);
+// Marks the functions still being compiled, which nothing else reaches.
+void compiler_mark_roots(vm_t *vm);
+
+#endif // COMPILER_H
@@ -52,43 +52,146 @@ void doubly_linked_list_insert_after(doubly_linked_list_t *list,
 
 void doubly_linked_list_insert_beginning(doubly_linked_list_t *list,
                                          doubly_linked_node_t *new_node) {
-  if (list->size == 0) {
-    list->head = new_node;
-    list->tail = new_node;
-    list->size++;
-  } else {
-    doubly_linked_list_insert_before(list, list->head, new_node);
-  }
+  doubly_linked_list_insert_before(list, list->head, new_node);
 }
 
 void doubly_linked_list_insert_end(doubly_linked_list_t *list,
                                    doubly_linked_node_t *new_node) {
-  if (list->size == 0) {
-    doubly_linked_list_insert_beginning(list, new_node);
-  } else {
-    doubly_linked_list_insert_after(list, list->tail, new_node);
-  }
+  doubly_linked_list_insert_after(list, list->tail, new_node);
 }
 
 void doubly_linked_list_remove(doubly_linked_list_t *list,
                                doubly_linked_node_t *node) {
   if (list->size == 0) {
     return;
-  } else if (list->size == 1) {
-    list->head = NULL;
-    list->tail = NULL;
-    list->size = 0;
-  } else if (node == list->head) {
+  }
+  if (node->prev != NULL) {
+    node->prev->next = node->next;
+  } else {
     list->head = node->next;
-    list->head->prev = NULL;
-    list->size--;
-  } else if (node == list->tail) {
+  }
+  if (node->next != NULL) {
+    node->next->prev = node->prev;
+  } else {
     list->tail = node->prev;
-    list->tail->next = NULL;
-    list->size--;
+  }
+  node->next = NULL;
+  node->prev = NULL;
+  list->size--;
+}
+
+doubly_linked_node_t *doubly_linked_list_pop_front(doubly_linked_list_t *list) {
+  doubly_linked_node_t *node = list->head;
+  if (node != NULL) {
+    doubly_linked_list_remove(list, node);
+  }
+  return node;
+}
+
+doubly_linked_node_t *doubly_linked_list_pop_back(doubly_linked_list_t *list) {
+  doubly_linked_node_t *node = list->tail;
+  if (node != NULL) {
+    doubly_linked_list_remove(list, node);
+  }
+  return node;
+}
+
+void doubly_linked_list_splice(doubly_linked_list_t *list,
+                               doubly_linked_node_t *node,
+                               doubly_linked_list_t *other) {
+  if (other->size == 0) {
+    return;
+  }
+  doubly_linked_node_t *next = node != NULL ? node->next : list->head;
+  other->head->prev = node;
+  other->tail->next = next;
+  if (node != NULL) {
+    node->next = other->head;
   } else {
-    node->prev->next = node->next;
-    node->next->prev = node->prev;
-    list->size--;
+    list->head = other->head;
+  }
+  if (next != NULL) {
+    next->prev = other->tail;
+  } else {
+    list->tail = other->tail;
+  }
+  list->size += other->size;
+  other->head = NULL;
+  other->tail = NULL;
+  other->size = 0;
+}
+
+void doubly_linked_list_concat(doubly_linked_list_t *list,
+                               doubly_linked_list_t *other) {
+  doubly_linked_list_splice(list, list->tail, other);
+}
+
+void doubly_linked_list_destroy(doubly_linked_list_t *list,
+                                doubly_linked_list_destroy_callback callback) {
+  if (callback != NULL) {
+    doubly_linked_node_t *node;
+    doubly_linked_node_t *next;
+    doubly_linked_list_for_each_safe(list, node, next) {
+      callback(node);
+    }
+  }
+  free(list);
+}
+
+doubly_linked_node_pool_t *doubly_linked_node_pool_new(size_t chunk_size) {
+  doubly_linked_node_pool_t *pool = malloc(sizeof(doubly_linked_node_pool_t));
+  pool->chunk_size = chunk_size > 0 ? chunk_size : 64;
+  pool->chunks = NULL;
+  pool->free_list = NULL;
+  pool->allocated = 0;
+  return pool;
+}
+
+static void doubly_linked_node_pool_grow(doubly_linked_node_pool_t *pool) {
+  size_t size = sizeof(doubly_linked_node_chunk_t) +
+                pool->chunk_size * sizeof(doubly_linked_node_t);
+  size = (size + DOUBLY_LINKED_NODE_POOL_ALIGNMENT - 1) &
+         ~(size_t)(DOUBLY_LINKED_NODE_POOL_ALIGNMENT - 1);
+  doubly_linked_node_chunk_t *chunk =
+      aligned_alloc(DOUBLY_LINKED_NODE_POOL_ALIGNMENT, size);
+  chunk->next = pool->chunks;
+  pool->chunks = chunk;
+  // Thread the free list front to back so nodes come out in address order.
+  for (size_t i = pool->chunk_size; i > 0; i--) {
+    chunk->nodes[i - 1].next = pool->free_list;
+    pool->free_list = &chunk->nodes[i - 1];
+  }
+}
+
+doubly_linked_node_t *
+doubly_linked_node_pool_alloc(doubly_linked_node_pool_t *pool) {
+  if (pool->free_list == NULL) {
+    doubly_linked_node_pool_grow(pool);
+  }
+  doubly_linked_node_t *node = pool->free_list;
+  pool->free_list = node->next;
+  node->next = NULL;
+  node->prev = NULL;
+  node->data = NULL;
+  pool->allocated++;
+  return node;
+}
+
+void doubly_linked_node_pool_release(doubly_linked_node_pool_t *pool,
+                                     doubly_linked_node_t *node) {
+  node->prev = NULL;
+  node->data = NULL;
+  node->next = pool->free_list;
+  pool->free_list = node;
+  pool->allocated--;
+}
+
+void doubly_linked_node_pool_free(doubly_linked_node_pool_t *pool) {
+  doubly_linked_node_chunk_t *chunk = pool->chunks;
+  while (chunk != NULL) {
+    doubly_linked_node_chunk_t *next = chunk->next;
+    free(chunk);
+    chunk = next;
   }
+  free(pool);
 }
@@ -1,6 +1,7 @@
 #ifndef DOUBLY_LINKED_LIST_H
 #define DOUBLY_LINKED_LIST_H
 
+#include <stddef.h>
 #include <stdlib.h>
 
 typedef struct doubly_linked_node_t {
@@ -12,10 +13,55 @@ typedef struct doubly_linked_node_t {
 typedef struct doubly_linked_list_t {
   doubly_linked_node_t *head;
   doubly_linked_node_t *tail;
-  int size;
+  size_t size;
 } doubly_linked_list_t;
 
+typedef void (^doubly_linked_list_destroy_callback)(doubly_linked_node_t *node);
+
+/*
+  Walks the list while allowing the current node to be removed (or freed):
+  next is loaded before the loop body runs.
+*/
+#define doubly_linked_list_for_each_safe(list, node, next_node)                \
+  for ((node) = (list)->head, (next_node) = (node) ? (node)->next : NULL;      \
+       (node) != NULL;                                                         \
+       (node) = (next_node), (next_node) = (node) ? (node)->next : NULL)
+
+/*
+  Intrusive use: embed a doubly_linked_node_t in your own struct, link that
+  member, and recover the struct from a node with
+  doubly_linked_list_container_of instead of going through data.
+*/
+#define doubly_linked_list_container_of(node, type, member)                    \
+  ((type *)((char *)(node)-offsetof(type, member)))
+
+#define DOUBLY_LINKED_NODE_POOL_ALIGNMENT 64
+
+typedef struct doubly_linked_node_chunk_t {
+  struct doubly_linked_node_chunk_t *next;
+  doubly_linked_node_t nodes[];
+} doubly_linked_node_chunk_t;
+
+/*
+  Hands out nodes from cache-line aligned chunks of chunk_size nodes.
+  Released nodes go on a free list (linked through next) and are reused
+  before a new chunk is allocated; chunks are only returned to the system by
+  doubly_linked_node_pool_free.
+*/
+typedef struct doubly_linked_node_pool_t {
+  size_t chunk_size;
+  doubly_linked_node_chunk_t *chunks;
+  doubly_linked_node_t *free_list;
+  size_t allocated;
+} doubly_linked_node_pool_t;
+
 doubly_linked_list_t *doubly_linked_list_new();
+void doubly_linked_list_insert_before(doubly_linked_list_t *list,
+                                      doubly_linked_node_t *node,
+                                      doubly_linked_node_t *new_node);
+void doubly_linked_list_insert_after(doubly_linked_list_t *list,
+                                     doubly_linked_node_t *node,
+                                     doubly_linked_node_t *new_node);
 void doubly_linked_list_insert_beginning(doubly_linked_list_t *list,
                                          doubly_linked_node_t *new_node);
 void doubly_linked_list_insert_end(doubly_linked_list_t *list,
@@ -23,5 +69,31 @@ void doubly_linked_list_insert_end(doubly_linked_list_t *list,
 
 void doubly_linked_list_remove(doubly_linked_list_t *list,
                                doubly_linked_node_t *node);
+doubly_linked_node_t *doubly_linked_list_pop_front(doubly_linked_list_t *list);
+doubly_linked_node_t *doubly_linked_list_pop_back(doubly_linked_list_t *list);
+
+/*
+  Moves every node of other into list after node (or at the front when node
+  is NULL) and leaves other empty. Only the boundary links are touched.
+*/
+void doubly_linked_list_splice(doubly_linked_list_t *list,
+                               doubly_linked_node_t *node,
+                               doubly_linked_list_t *other);
+void doubly_linked_list_concat(doubly_linked_list_t *list,
+                               doubly_linked_list_t *other);
+
+/*
+  Frees the list, handing each node to callback first (callback may be NULL
+  when the nodes are owned elsewhere).
+*/
+void doubly_linked_list_destroy(doubly_linked_list_t *list,
+                                doubly_linked_list_destroy_callback callback);
+
+doubly_linked_node_pool_t *doubly_linked_node_pool_new(size_t chunk_size);
+doubly_linked_node_t *
+doubly_linked_node_pool_alloc(doubly_linked_node_pool_t *pool);
+void doubly_linked_node_pool_release(doubly_linked_node_pool_t *pool,
+                                     doubly_linked_node_t *node);
+void doubly_linked_node_pool_free(doubly_linked_node_pool_t *pool);
 
 #endif // DOUBLY_LINKED_LIST_H
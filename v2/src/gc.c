@@ -0,0 +1,391 @@
+#include "gc.h"
+#include "compiler.h"
+#include "vm.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef GC_STRESS
+#define GC_STRESS_DEFAULT 1
+#else
+#define GC_STRESS_DEFAULT 0
+#endif
+
+#ifdef GC_INCREMENTAL
+#define GC_MODE_DEFAULT GC_MODE_INCREMENTAL
+#else
+#define GC_MODE_DEFAULT GC_MODE_STOP_THE_WORLD
+#endif
+
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define GC_NO_POOL
+#endif
+#endif
+#ifdef __SANITIZE_ADDRESS__
+#define GC_NO_POOL
+#endif
+
+#ifdef GC_LOG
+#define GC_LOG_DEFAULT stderr
+#else
+#define GC_LOG_DEFAULT NULL
+#endif
+
+static void slice(vm_t *vm, size_t budget);
+
+void gc_init(gc_t *gc) {
+  gc->mode = GC_MODE_DEFAULT;
+  gc->phase = GC_IDLE;
+  gc->bytes_allocated = 0;
+  gc->next_gc = GC_INITIAL_THRESHOLD;
+  gc->growth_factor = GC_GROWTH_FACTOR;
+  gc->marked_bytes = 0;
+  gc->debt = 0;
+  gc->stress = GC_STRESS_DEFAULT;
+  gc->collections = 0;
+  gc->gray_stack = NULL;
+  gc->gray_count = 0;
+  gc->gray_capacity = 0;
+  gc->pool = arena(GC_POOL_BLOCK_SIZE);
+  memset(gc->free_cells, 0, sizeof gc->free_cells);
+  gc->sweep_next = NULL;
+  memset(&gc->cycle_pauses, 0, sizeof gc->cycle_pauses);
+  memset(&gc->pauses, 0, sizeof gc->pauses);
+  gc->cycle_start_bytes = 0;
+  gc->log = GC_LOG_DEFAULT;
+}
+
+void gc_free(gc_t *gc) {
+  free(gc->gray_stack);
+  gc->gray_stack = NULL;
+  gc->gray_capacity = 0;
+  arenaFree(gc->pool);
+  gc->pool = NULL;
+}
+
+void *gc_allocate(vm_t *vm, size_t size) {
+  gc_t *gc = &vm->gc;
+  if (gc->mode == GC_MODE_STOP_THE_WORLD) {
+    if (gc->stress || gc->bytes_allocated + size > gc->next_gc) {
+      gc_collect(vm);
+    }
+  } else if (gc->stress) {
+    slice(vm, size * GC_STEP_MULTIPLIER);
+  } else if (gc->phase != GC_IDLE) {
+    gc->debt += size;
+    if (gc->debt >= GC_STEP_SIZE) {
+      slice(vm, gc->debt * GC_STEP_MULTIPLIER);
+      gc->debt = 0;
+    }
+  } else if (gc->bytes_allocated + size > gc->next_gc) {
+    slice(vm, GC_STEP_SIZE * GC_STEP_MULTIPLIER);
+  }
+  if (gc->phase == GC_MARKING) {
+    // gc_track will mark the new object without counting it.
+    gc->marked_bytes += size;
+  }
+  gc->bytes_allocated += size;
+
+#ifdef GC_NO_POOL
+  return malloc(size);
+#else
+  if (size > GC_POOL_MAX) {
+    return malloc(size);
+  }
+  size_t class = size == 0 ? 0 : (size - 1) / GC_POOL_CLASS;
+  gc_free_cell_t *cell = gc->free_cells[class];
+  if (cell != NULL) {
+    gc->free_cells[class] = cell->next;
+    return cell;
+  }
+  return arenaAlloc(gc->pool, (class + 1) * GC_POOL_CLASS);
+#endif
+}
+
+void gc_release(vm_t *vm, void *pointer, size_t size) {
+  gc_t *gc = &vm->gc;
+  gc->bytes_allocated -= size;
+  if (gc->phase == GC_MARKING) {
+    // Only memory allocated (and counted) in this marking phase is
+    // released during it; the sweep frees everything else.
+    gc->marked_bytes -= size;
+  }
+#ifdef GC_NO_POOL
+  free(pointer);
+#else
+  if (size > GC_POOL_MAX) {
+    free(pointer);
+    return;
+  }
+  size_t class = size == 0 ? 0 : (size - 1) / GC_POOL_CLASS;
+  gc_free_cell_t *cell = pointer;
+  cell->next = gc->free_cells[class];
+  gc->free_cells[class] = cell;
+#endif
+}
+
+// Marks object and queues it to be scanned, unless it is a leaf: those
+// reference nothing, so they go straight to black.
+static void mark_gray(gc_t *gc, obj_t *object) {
+  object->is_marked = 1;
+  if (object->type == OBJ_STRING || object->type == OBJ_NATIVE) {
+    return;
+  }
+  if (gc->gray_count == gc->gray_capacity) {
+    gc->gray_capacity = gc->gray_capacity < 64 ? 64 : gc->gray_capacity * 2;
+    // The gray stack lives outside the managed heap, so growing it can't
+    // start a collection.
+    gc->gray_stack =
+        realloc(gc->gray_stack, gc->gray_capacity * sizeof(obj_t *));
+  }
+  gc->gray_stack[gc->gray_count++] = object;
+}
+
+void gc_track(vm_t *vm, obj_t *object) {
+  object->is_marked = 0;
+  switch (vm->gc.phase) {
+  case GC_IDLE:
+    break;
+  case GC_MARKING:
+    // Gray rather than black: the caller hasn't stored its fields yet.
+    mark_gray(&vm->gc, object);
+    break;
+  case GC_SWEEPING:
+    // The sweep clears the mark when it reaches the object.
+    object->is_marked = 1;
+    break;
+  }
+}
+
+void gc_mark_object(vm_t *vm, obj_t *object) {
+  if (object == NULL || object->is_marked) {
+    return;
+  }
+  vm->gc.marked_bytes += object_size(object);
+  mark_gray(&vm->gc, object);
+}
+
+void gc_mark_value(vm_t *vm, value_t value) {
+  if (value_is_obj(value)) {
+    gc_mark_object(vm, value_as_obj(value));
+  }
+}
+
+void gc_write_barrier(vm_t *vm, obj_t *object, value_t value) {
+  if (vm->gc.phase == GC_MARKING && object->is_marked) {
+    gc_mark_value(vm, value);
+  }
+}
+
+static void mark_table(vm_t *vm, table_t *table) {
+  for (size_t i = 0; i < table->capacity; i++) {
+    table_entry_t *entry = &table->entries[i];
+    if (entry->key != NULL) {
+      gc_mark_object(vm, &entry->key->obj);
+      gc_mark_value(vm, entry->value);
+    }
+  }
+}
+
+static void mark_roots(vm_t *vm) {
+  for (value_t *slot = vm->stack; slot < vm->stack_top; slot++) {
+    gc_mark_value(vm, *slot);
+  }
+  for (int i = 0; i < vm->frame_count; i++) {
+    gc_mark_object(vm, &vm->frames[i].closure->obj);
+  }
+  for (obj_upvalue_t *upvalue = vm->open_upvalues; upvalue != NULL;
+       upvalue = upvalue->next) {
+    gc_mark_object(vm, &upvalue->obj);
+  }
+  mark_table(vm, &vm->globals);
+  gc_mark_object(vm, (obj_t *)vm->init_string);
+  compiler_mark_roots(vm);
+}
+
+// Marks everything object references, turning it from gray to black.
+// Returns the bytes scanned, as a measure of the work done.
+static size_t blacken_object(vm_t *vm, obj_t *object) {
+  size_t work = object_size(object);
+  switch (object->type) {
+  case OBJ_BOUND_METHOD: {
+    obj_bound_method_t *bound = (obj_bound_method_t *)object;
+    gc_mark_value(vm, bound->receiver);
+    gc_mark_object(vm, &bound->method->obj);
+    break;
+  }
+  case OBJ_CLASS: {
+    obj_class_t *klass = (obj_class_t *)object;
+    gc_mark_object(vm, &klass->name->obj);
+    mark_table(vm, &klass->methods);
+    work += klass->methods.capacity * sizeof(table_entry_t);
+    break;
+  }
+  case OBJ_CLOSURE: {
+    obj_closure_t *closure = (obj_closure_t *)object;
+    gc_mark_object(vm, &closure->function->obj);
+    for (int i = 0; i < closure->upvalue_count; i++) {
+      gc_mark_object(vm, (obj_t *)closure->upvalues[i]);
+    }
+    break;
+  }
+  case OBJ_FUNCTION: {
+    obj_function_t *function = (obj_function_t *)object;
+    gc_mark_object(vm, (obj_t *)function->name);
+    value_array_t *constants = &function->chunk.constants;
+    for (size_t i = 0; i < constants->count; i++) {
+      gc_mark_value(vm, constants->values[i]);
+    }
+    work += constants->count * sizeof(value_t);
+    break;
+  }
+  case OBJ_INSTANCE: {
+    obj_instance_t *instance = (obj_instance_t *)object;
+    gc_mark_object(vm, &instance->klass->obj);
+    mark_table(vm, &instance->fields);
+    work += instance->fields.capacity * sizeof(table_entry_t);
+    break;
+  }
+  case OBJ_UPVALUE:
+    gc_mark_value(vm, ((obj_upvalue_t *)object)->closed);
+    break;
+  case OBJ_NATIVE:
+  case OBJ_STRING:
+    break;
+  }
+  return work;
+}
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void record_pause(gc_pauses_t *pauses, double seconds) {
+  size_t bucket = 0;
+  for (double limit = 1e-6; seconds >= limit && bucket < GC_PAUSE_BUCKETS - 1;
+       limit *= 2) {
+    bucket++;
+  }
+  pauses->buckets[bucket]++;
+  pauses->count++;
+  pauses->total += seconds;
+  if (seconds > pauses->max) {
+    pauses->max = seconds;
+  }
+}
+
+void gc_print_pauses(FILE *out, const gc_pauses_t *pauses) {
+  fprintf(out, "%zu pauses, %.3f ms total, %.3f ms max:", pauses->count,
+          pauses->total * 1e3, pauses->max * 1e3);
+  for (size_t i = 0; i < GC_PAUSE_BUCKETS; i++) {
+    if (pauses->buckets[i] == 0) {
+      continue;
+    }
+    if (i == GC_PAUSE_BUCKETS - 1) {
+      fprintf(out, " >=%zuus %zu", (size_t)1 << (i - 1), pauses->buckets[i]);
+    } else {
+      fprintf(out, " <%zuus %zu", (size_t)1 << i, pauses->buckets[i]);
+    }
+  }
+  fprintf(out, "\n");
+}
+
+static void begin_cycle(vm_t *vm) {
+  gc_t *gc = &vm->gc;
+  gc->phase = GC_MARKING;
+  gc->cycle_start_bytes = gc->bytes_allocated;
+  gc->marked_bytes = 0;
+  mark_roots(vm);
+}
+
+// Ends marking atomically: roots stored since the cycle began are marked,
+// then everything they reach, so the sweep frees only garbage.
+static void finish_marking(vm_t *vm) {
+  gc_t *gc = &vm->gc;
+  mark_roots(vm);
+  while (gc->gray_count > 0) {
+    blacken_object(vm, gc->gray_stack[--gc->gray_count]);
+  }
+  table_remove_unmarked(&vm->strings);
+  gc->phase = GC_SWEEPING;
+  gc->sweep_next = vm->objects->head;
+}
+
+// Frees the object under the sweep cursor if it is unmarked, or clears its
+// mark for the next cycle. Returns its size, as a measure of the work done.
+static size_t sweep_object(vm_t *vm) {
+  gc_t *gc = &vm->gc;
+  doubly_linked_node_t *node = gc->sweep_next;
+  gc->sweep_next = node->next;
+  obj_t *object = doubly_linked_list_container_of(node, obj_t, link);
+  size_t work = object_size(object);
+  if (object->is_marked) {
+    object->is_marked = 0;
+  } else {
+    doubly_linked_list_remove(vm->objects, node);
+    object_free(vm, object);
+  }
+  return work;
+}
+
+static void end_cycle(vm_t *vm) {
+  gc_t *gc = &vm->gc;
+  gc->phase = GC_IDLE;
+  gc->debt = 0;
+  gc->next_gc = (size_t)((double)gc->marked_bytes * gc->growth_factor);
+  if (gc->next_gc < GC_INITIAL_THRESHOLD) {
+    gc->next_gc = GC_INITIAL_THRESHOLD;
+  }
+  gc->collections++;
+  if (gc->log != NULL) {
+    fprintf(gc->log, "gc %zu: %zu -> %zu bytes, next at %zu; ",
+            gc->collections, gc->cycle_start_bytes, gc->bytes_allocated,
+            gc->next_gc);
+    gc_print_pauses(gc->log, &gc->cycle_pauses);
+  }
+  memset(&gc->cycle_pauses, 0, sizeof gc->cycle_pauses);
+}
+
+// Does up to budget bytes of collector work as one timed pause, starting a
+// cycle if none is running. Always makes some progress.
+static void slice(vm_t *vm, size_t budget) {
+  gc_t *gc = &vm->gc;
+  double start = now();
+  if (gc->phase == GC_IDLE) {
+    begin_cycle(vm);
+  }
+  int finished = 0;
+  size_t work = 0;
+  while (work < budget && !finished) {
+    if (gc->phase == GC_MARKING) {
+      if (gc->gray_count > 0) {
+        work += blacken_object(vm, gc->gray_stack[--gc->gray_count]);
+      } else {
+        finish_marking(vm);
+      }
+    } else {
+      work += sweep_object(vm);
+    }
+    // The cycle must end as soon as the cursor runs off the list: objects
+    // allocated after that would be marked with no sweep left to clear them.
+    finished = gc->phase == GC_SWEEPING && gc->sweep_next == NULL;
+  }
+
+  double pause = now() - start;
+  record_pause(&gc->cycle_pauses, pause);
+  record_pause(&gc->pauses, pause);
+  if (finished) {
+    end_cycle(vm);
+  }
+}
+
+void gc_collect(vm_t *vm) {
+  if (vm->gc.phase != GC_IDLE) {
+    slice(vm, SIZE_MAX);
+  }
+  slice(vm, SIZE_MAX);
+}
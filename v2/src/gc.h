@@ -0,0 +1,132 @@
+#ifndef GC_H
+#define GC_H
+
+#include "doubly_linked_list.h"
+#include "value.h"
+#include <arena/arena.h>
+#include <stddef.h>
+#include <stdio.h>
+
+typedef struct vm_t vm_t;
+
+// The heap may grow to 1 MiB before the first collection.
+#define GC_INITIAL_THRESHOLD (1024 * 1024)
+#define GC_GROWTH_FACTOR 2.0
+// In incremental mode, a slice of collector work runs every GC_STEP_SIZE
+// bytes allocated and traces or sweeps GC_STEP_MULTIPLIER times as many
+// bytes of heap, so a cycle always finishes ahead of the mutator.
+#define GC_STEP_SIZE (16 * 1024)
+#define GC_STEP_MULTIPLIER 4
+// Allocations up to GC_POOL_MAX bytes are rounded up to a multiple of
+// GC_POOL_CLASS and served from the pool; larger ones go to malloc.
+#define GC_POOL_CLASS 16
+#define GC_POOL_MAX 256
+#define GC_POOL_BLOCK_SIZE (256 * 1024)
+// Pause histogram buckets: bucket i counts pauses shorter than 2^i
+// microseconds that didn't fit an earlier bucket; the last takes the rest.
+#define GC_PAUSE_BUCKETS 16
+
+typedef enum gc_mode_t {
+  // Each collection marks and sweeps the whole heap in one pause.
+  GC_MODE_STOP_THE_WORLD,
+  // A collection is spread over many short slices between allocations.
+  GC_MODE_INCREMENTAL,
+} gc_mode_t;
+
+typedef enum gc_phase_t {
+  GC_IDLE,
+  GC_MARKING,
+  GC_SWEEPING,
+} gc_phase_t;
+
+// A pooled allocation on its size class's free list.
+typedef struct gc_free_cell_t {
+  struct gc_free_cell_t *next;
+} gc_free_cell_t;
+
+typedef struct gc_pauses_t {
+  size_t buckets[GC_PAUSE_BUCKETS];
+  size_t count;
+  // In seconds.
+  double total;
+  double max;
+} gc_pauses_t;
+
+/*
+  Collector state, embedded in vm_t. The collector is a precise, non-moving
+  mark-sweep: every heap object is on vm->objects, and marking traces from
+  the vm's roots through a gray stack of objects that are marked but not yet
+  scanned, so deep object graphs don't recurse. Interned strings are held
+  weakly: any the mark phase didn't reach are removed from the intern set
+  before the sweep frees them.
+
+  Small objects live in a pool: fresh memory is bump-allocated from an
+  arena, and the sweep pushes freed objects onto per-size-class free lists
+  for reuse. The pool is only returned to the system by gc_free. Under
+  AddressSanitizer every allocation goes to malloc instead, so a use of a
+  swept object is still reported.
+
+  In incremental mode the mutator runs between slices of a cycle. Objects
+  allocated mid-cycle are marked, and stores into heap objects go through
+  gc_write_barrier so a scanned object never hides an unmarked one. The
+  roots themselves are not barriered: marking ends by rescanning them in
+  one short atomic step before the sweep starts.
+*/
+typedef struct gc_t {
+  // GC_MODE_STOP_THE_WORLD unless built with -DGC_INCREMENTAL.
+  gc_mode_t mode;
+  gc_phase_t phase;
+  // Bytes held by heap objects, and the total that starts the next
+  // collection. After a collection the threshold becomes the bytes marked
+  // live times growth_factor, but never less than GC_INITIAL_THRESHOLD.
+  // (Marked rather than surviving bytes: an incremental cycle also keeps
+  // everything allocated while it ran, which would inflate the threshold
+  // from one cycle to the next.)
+  size_t bytes_allocated;
+  size_t next_gc;
+  double growth_factor;
+  size_t marked_bytes;
+  // Bytes allocated since the last incremental slice.
+  size_t debt;
+  // Collect before every allocation (in incremental mode, run a slice
+  // after every allocation), to shake out missing roots and barriers.
+  int stress;
+  size_t collections;
+  obj_t **gray_stack;
+  size_t gray_count;
+  size_t gray_capacity;
+  arena_t *pool;
+  gc_free_cell_t *free_cells[GC_POOL_MAX / GC_POOL_CLASS];
+  // The next object an incremental sweep will look at.
+  doubly_linked_node_t *sweep_next;
+  // Pauses in the current cycle, and across the vm's lifetime. When log is
+  // set (stderr when built with -DGC_LOG), each finished cycle writes a
+  // line with its pause histogram there.
+  gc_pauses_t cycle_pauses;
+  gc_pauses_t pauses;
+  size_t cycle_start_bytes;
+  FILE *log;
+} gc_t;
+
+void gc_init(gc_t *gc);
+void gc_free(gc_t *gc);
+// Allocates size bytes of object memory, collecting first (or running a
+// slice of the current cycle) when the heap has outgrown its threshold.
+// Everything the caller still needs must be reachable from a root.
+void *gc_allocate(vm_t *vm, size_t size);
+// Frees memory from gc_allocate; size must match the request. While a
+// cycle is marking, only memory allocated since marking began (such as a
+// duplicate string dropped in favor of its interned copy) may be released.
+void gc_release(vm_t *vm, void *pointer, size_t size);
+// Colors a newly allocated object so a cycle in progress keeps it.
+void gc_track(vm_t *vm, obj_t *object);
+// Runs a full collection in one pause, finishing any cycle in progress.
+void gc_collect(vm_t *vm);
+void gc_mark_value(vm_t *vm, value_t value);
+void gc_mark_object(vm_t *vm, obj_t *object);
+// Must be called when value is stored into object. While a cycle is
+// marking, object may already have been scanned, so value is marked too.
+void gc_write_barrier(vm_t *vm, obj_t *object, value_t value);
+void gc_print_pauses(FILE *out, const gc_pauses_t *pauses);
+
+#endif // GC_H
@@ -0,0 +1,83 @@
+#include "scanner.h"
+#include "source.h"
+#include "vm.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define EXIT_USAGE 64
+#define EXIT_DATA_ERROR 65
+#define EXIT_SOFTWARE 70
+#define EXIT_IO_ERROR 74
+
+static int exit_status(interpret_result_t result) {
+  switch (result) {
+  case INTERPRET_COMPILE_ERROR:
+    return EXIT_DATA_ERROR;
+  case INTERPRET_RUNTIME_ERROR:
+    return EXIT_SOFTWARE;
+  default:
+    return 0;
+  }
+}
+
+static int run_source(source_t *source) {
+  scanner_t scanner;
+  scanner_init_padded(&scanner, source->text, source->length);
+  vm_t *vm = vm_new();
+  interpret_result_t result = vm_interpret(vm, &scanner);
+  vm_free(vm);
+  source_free(source);
+  return exit_status(result);
+}
+
+static int run_file(const char *path) {
+  source_t *source = source_open(path);
+  if (source == NULL) {
+    fprintf(stderr, "Could not read \"%s\": %s\n", path, strerror(errno));
+    return EXIT_IO_ERROR;
+  }
+  return run_source(source);
+}
+
+static int run_prompt() {
+  char *line = NULL;
+  size_t capacity = 0;
+  ssize_t length;
+  // One vm for the whole session, so globals outlive the line.
+  vm_t *vm = vm_new();
+  for (;;) {
+    printf("> ");
+    fflush(stdout);
+    if ((length = getline(&line, &capacity, stdin)) < 0) {
+      break;
+    }
+    scanner_t scanner;
+    scanner_init(&scanner, line, (size_t)length);
+    vm_interpret(vm, &scanner);
+  }
+  vm_free(vm);
+  free(line);
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc > 2) {
+    fprintf(stderr, "Usage: lox [script]\n");
+    return EXIT_USAGE;
+  }
+  if (argc == 2) {
+    return run_file(argv[1]);
+  }
+  if (isatty(STDIN_FILENO)) {
+    return run_prompt();
+  }
+  source_t *source = source_read_fd(STDIN_FILENO);
+  if (source == NULL) {
+    fprintf(stderr, "Could not read standard input: %s\n", strerror(errno));
+    return EXIT_IO_ERROR;
+  }
+  return run_source(source);
+}
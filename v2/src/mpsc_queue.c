@@ -0,0 +1,97 @@
+#include "mpsc_queue.h"
+#include <sched.h>
+
+mpsc_queue_t *mpsc_queue_new() {
+  mpsc_queue_t *queue = aligned_alloc(
+      MPSC_QUEUE_CACHE_LINE,
+      (sizeof(mpsc_queue_t) + MPSC_QUEUE_CACHE_LINE - 1) &
+          ~(size_t)(MPSC_QUEUE_CACHE_LINE - 1));
+  queue->stub.next = NULL;
+  queue->stub.prev = NULL;
+  queue->stub.data = NULL;
+  queue->head = &queue->stub;
+  queue->tail = &queue->stub;
+  queue->parked = 0;
+  pthread_mutex_init(&queue->lock, NULL);
+  pthread_cond_init(&queue->ready, NULL);
+  return queue;
+}
+
+void mpsc_queue_free(mpsc_queue_t *queue) {
+  pthread_cond_destroy(&queue->ready);
+  pthread_mutex_destroy(&queue->lock);
+  free(queue);
+}
+
+static void mpsc_queue_link(mpsc_queue_t *queue, doubly_linked_node_t *node) {
+  __atomic_store_n(&node->next, NULL, __ATOMIC_RELAXED);
+  doubly_linked_node_t *prev =
+      __atomic_exchange_n(&queue->head, node, __ATOMIC_ACQ_REL);
+  __atomic_store_n(&prev->next, node, __ATOMIC_RELEASE);
+}
+
+void mpsc_queue_push(mpsc_queue_t *queue, doubly_linked_node_t *node) {
+  mpsc_queue_link(queue, node);
+  // Pairs with the fence in mpsc_queue_wait: either the consumer sees the
+  // node before parking or we see parked and wake it.
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&queue->parked, __ATOMIC_RELAXED)) {
+    pthread_mutex_lock(&queue->lock);
+    pthread_cond_signal(&queue->ready);
+    pthread_mutex_unlock(&queue->lock);
+  }
+}
+
+doubly_linked_node_t *mpsc_queue_pop(mpsc_queue_t *queue) {
+  doubly_linked_node_t *tail = queue->tail;
+  doubly_linked_node_t *next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+  if (tail == &queue->stub) {
+    if (next == NULL) {
+      return NULL;
+    }
+    queue->tail = next;
+    tail = next;
+    next = __atomic_load_n(&next->next, __ATOMIC_ACQUIRE);
+  }
+  if (next != NULL) {
+    queue->tail = next;
+    return tail;
+  }
+  // tail is the last linked node. Hand it out only once the stub is queued
+  // behind it, so there is always a node left for producers to link onto.
+  if (tail != __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE)) {
+    return NULL;
+  }
+  mpsc_queue_link(queue, &queue->stub);
+  next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+  if (next != NULL) {
+    queue->tail = next;
+    return tail;
+  }
+  return NULL;
+}
+
+doubly_linked_node_t *mpsc_queue_wait(mpsc_queue_t *queue) {
+  for (;;) {
+    for (int spin = 0; spin < MPSC_QUEUE_SPIN_LIMIT; spin++) {
+      doubly_linked_node_t *node = mpsc_queue_pop(queue);
+      if (node != NULL) {
+        return node;
+      }
+      sched_yield();
+    }
+
+    pthread_mutex_lock(&queue->lock);
+    __atomic_store_n(&queue->parked, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    doubly_linked_node_t *node = mpsc_queue_pop(queue);
+    if (node == NULL) {
+      pthread_cond_wait(&queue->ready, &queue->lock);
+    }
+    __atomic_store_n(&queue->parked, 0, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&queue->lock);
+    if (node != NULL) {
+      return node;
+    }
+  }
+}
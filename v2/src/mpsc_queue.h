@@ -0,0 +1,47 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include "doubly_linked_list.h"
+#include <pthread.h>
+
+#define MPSC_QUEUE_CACHE_LINE 64
+#define MPSC_QUEUE_SPIN_LIMIT 128
+
+/*
+  Intrusive multi-producer/single-consumer queue (Dmitry Vyukov's design)
+  over doubly_linked_node_t, so a node can move between a queue and a
+  doubly_linked_list_t without being copied. Only next is used while a node
+  is queued; prev and data are left to the caller.
+
+  Producers publish with a single atomic exchange on head and never wait on
+  each other. The consumer owns tail and the stub node. The only wait is
+  mpsc_queue_wait parking on a condition variable once the queue has stayed
+  empty for MPSC_QUEUE_SPIN_LIMIT polls. Producers take the mutex only while
+  the consumer is parked.
+*/
+typedef struct mpsc_queue_t {
+  doubly_linked_node_t *head;
+  char head_padding[MPSC_QUEUE_CACHE_LINE - sizeof(doubly_linked_node_t *)];
+  doubly_linked_node_t *tail;
+  doubly_linked_node_t stub;
+  int parked;
+  pthread_mutex_t lock;
+  pthread_cond_t ready;
+} mpsc_queue_t;
+
+mpsc_queue_t *mpsc_queue_new();
+void mpsc_queue_free(mpsc_queue_t *queue);
+
+// Safe to call from any number of threads.
+void mpsc_queue_push(mpsc_queue_t *queue, doubly_linked_node_t *node);
+
+/*
+  Consumer only. Returns NULL when the queue is empty, or when a producer is
+  between its exchange and its link and the next node is not yet reachable.
+*/
+doubly_linked_node_t *mpsc_queue_pop(mpsc_queue_t *queue);
+
+// Consumer only. Blocks until a node is available.
+doubly_linked_node_t *mpsc_queue_wait(mpsc_queue_t *queue);
+
+#endif // MPSC_QUEUE_H
@@ -0,0 +1,223 @@
+#include "object.h"
+#include "gc.h"
+#include "vm.h"
+#include <stdlib.h>
+#include <string.h>
+
+static obj_t *allocate_object(vm_t *vm, size_t size, obj_type_t type) {
+  obj_t *object = gc_allocate(vm, size);
+  object->type = type;
+  gc_track(vm, object);
+  doubly_linked_list_insert_end(vm->objects, &object->link);
+  return object;
+}
+
+#define allocate(vm, type, obj_type)                                           \
+  ((type *)allocate_object(vm, sizeof(type), obj_type))
+
+obj_bound_method_t *object_new_bound_method(vm_t *vm, value_t receiver,
+                                            obj_closure_t *method) {
+  obj_bound_method_t *bound =
+      allocate(vm, obj_bound_method_t, OBJ_BOUND_METHOD);
+  bound->receiver = receiver;
+  bound->method = method;
+  return bound;
+}
+
+obj_class_t *object_new_class(vm_t *vm, obj_string_t *name) {
+  obj_class_t *klass = allocate(vm, obj_class_t, OBJ_CLASS);
+  klass->name = name;
+  table_init(&klass->methods);
+  return klass;
+}
+
+obj_closure_t *object_new_closure(vm_t *vm, obj_function_t *function) {
+  size_t size = sizeof(obj_upvalue_t *) * (size_t)function->upvalue_count;
+  obj_upvalue_t **upvalues = gc_allocate(vm, size);
+  for (int i = 0; i < function->upvalue_count; i++) {
+    upvalues[i] = NULL;
+  }
+  obj_closure_t *closure = allocate(vm, obj_closure_t, OBJ_CLOSURE);
+  closure->function = function;
+  closure->upvalues = upvalues;
+  closure->upvalue_count = function->upvalue_count;
+  return closure;
+}
+
+obj_function_t *object_new_function(vm_t *vm) {
+  obj_function_t *function = allocate(vm, obj_function_t, OBJ_FUNCTION);
+  function->arity = 0;
+  function->upvalue_count = 0;
+  function->name = NULL;
+  chunk_init(&function->chunk);
+  return function;
+}
+
+obj_instance_t *object_new_instance(vm_t *vm, obj_class_t *klass) {
+  obj_instance_t *instance = allocate(vm, obj_instance_t, OBJ_INSTANCE);
+  instance->klass = klass;
+  table_init(&instance->fields);
+  return instance;
+}
+
+obj_native_t *object_new_native(vm_t *vm, native_fn_t function) {
+  obj_native_t *native = allocate(vm, obj_native_t, OBJ_NATIVE);
+  native->function = function;
+  return native;
+}
+
+obj_upvalue_t *object_new_upvalue(vm_t *vm, value_t *slot) {
+  obj_upvalue_t *upvalue = allocate(vm, obj_upvalue_t, OBJ_UPVALUE);
+  upvalue->location = slot;
+  upvalue->closed = value_nil();
+  upvalue->next = NULL;
+  return upvalue;
+}
+
+// FNV-1a, the same hash string_t caches.
+static uint32_t hash_chars(uint32_t hash, const char *chars, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    hash ^= (uint8_t)chars[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+#define HASH_SEED 2166136261u
+
+// Allocates a string that is not yet owned by the vm or interned.
+static obj_string_t *new_string(vm_t *vm, size_t length, uint32_t hash) {
+  obj_string_t *string = gc_allocate(vm, sizeof(obj_string_t) + length + 1);
+  string->obj.type = OBJ_STRING;
+  string->length = length;
+  string->hash = hash;
+  string->chars[length] = '\0';
+  return string;
+}
+
+static obj_string_t *intern(vm_t *vm, obj_string_t *string) {
+  gc_track(vm, &string->obj);
+  doubly_linked_list_insert_end(vm->objects, &string->obj.link);
+  table_set(&vm->strings, string, value_nil());
+  return string;
+}
+
+obj_string_t *object_copy_string(vm_t *vm, const char *chars, size_t length) {
+  uint32_t hash = hash_chars(HASH_SEED, chars, length);
+  obj_string_t *interned = table_find_string(&vm->strings, chars, length, hash);
+  if (interned != NULL) {
+    return interned;
+  }
+  obj_string_t *string = new_string(vm, length, hash);
+  memcpy(string->chars, chars, length);
+  return intern(vm, string);
+}
+
+obj_string_t *object_concat_strings(vm_t *vm, obj_string_t *a,
+                                    obj_string_t *b) {
+  size_t length = a->length + b->length;
+  uint32_t hash = hash_chars(hash_chars(HASH_SEED, a->chars, a->length),
+                             b->chars, b->length);
+  obj_string_t *string = new_string(vm, length, hash);
+  memcpy(string->chars, a->chars, a->length);
+  memcpy(string->chars + a->length, b->chars, b->length);
+
+  obj_string_t *interned =
+      table_find_string(&vm->strings, string->chars, length, hash);
+  if (interned != NULL) {
+    gc_release(vm, string, sizeof(obj_string_t) + length + 1);
+    return interned;
+  }
+  return intern(vm, string);
+}
+
+static void print_function(FILE *out, obj_function_t *function) {
+  if (function->name == NULL) {
+    fprintf(out, "<script>");
+  } else {
+    fprintf(out, "<fn %s>", function->name->chars);
+  }
+}
+
+void object_print(FILE *out, value_t value) {
+  obj_t *object = value_as_obj(value);
+  switch (object->type) {
+  case OBJ_BOUND_METHOD:
+    print_function(out, ((obj_bound_method_t *)object)->method->function);
+    break;
+  case OBJ_CLASS:
+    fprintf(out, "%s", ((obj_class_t *)object)->name->chars);
+    break;
+  case OBJ_CLOSURE:
+    print_function(out, ((obj_closure_t *)object)->function);
+    break;
+  case OBJ_FUNCTION:
+    print_function(out, (obj_function_t *)object);
+    break;
+  case OBJ_INSTANCE:
+    fprintf(out, "%s instance",
+            ((obj_instance_t *)object)->klass->name->chars);
+    break;
+  case OBJ_NATIVE:
+    fprintf(out, "<native fn>");
+    break;
+  case OBJ_STRING:
+    fprintf(out, "%s", ((obj_string_t *)object)->chars);
+    break;
+  case OBJ_UPVALUE:
+    fprintf(out, "upvalue");
+    break;
+  }
+}
+
+size_t object_size(obj_t *object) {
+  switch (object->type) {
+  case OBJ_BOUND_METHOD:
+    return sizeof(obj_bound_method_t);
+  case OBJ_CLASS:
+    return sizeof(obj_class_t);
+  case OBJ_CLOSURE:
+    return sizeof(obj_closure_t) +
+           sizeof(obj_upvalue_t *) *
+               (size_t)((obj_closure_t *)object)->upvalue_count;
+  case OBJ_FUNCTION:
+    return sizeof(obj_function_t);
+  case OBJ_INSTANCE:
+    return sizeof(obj_instance_t);
+  case OBJ_NATIVE:
+    return sizeof(obj_native_t);
+  case OBJ_STRING:
+    return sizeof(obj_string_t) + ((obj_string_t *)object)->length + 1;
+  case OBJ_UPVALUE:
+    return sizeof(obj_upvalue_t);
+  }
+  return 0;
+}
+
+void object_free(vm_t *vm, obj_t *object) {
+  size_t size = object_size(object);
+  switch (object->type) {
+  case OBJ_CLASS:
+    table_free(&((obj_class_t *)object)->methods);
+    break;
+  case OBJ_CLOSURE: {
+    obj_closure_t *closure = (obj_closure_t *)object;
+    size_t upvalues = sizeof(obj_upvalue_t *) * (size_t)closure->upvalue_count;
+    gc_release(vm, closure->upvalues, upvalues);
+    size -= upvalues;
+    break;
+  }
+  case OBJ_FUNCTION:
+    chunk_free(&((obj_function_t *)object)->chunk);
+    break;
+  case OBJ_INSTANCE:
+    table_free(&((obj_instance_t *)object)->fields);
+    break;
+  case OBJ_BOUND_METHOD:
+  case OBJ_NATIVE:
+  case OBJ_STRING:
+  case OBJ_UPVALUE:
+    break;
+  }
+  gc_release(vm, object, size);
+}
@@ -0,0 +1,124 @@
+#ifndef OBJECT_H
+#define OBJECT_H
+
+#include "chunk.h"
+#include "doubly_linked_list.h"
+#include "table.h"
+#include "value.h"
+
+typedef struct vm_t vm_t;
+
+typedef enum obj_type_t {
+  OBJ_BOUND_METHOD,
+  OBJ_CLASS,
+  OBJ_CLOSURE,
+  OBJ_FUNCTION,
+  OBJ_INSTANCE,
+  OBJ_NATIVE,
+  OBJ_STRING,
+  OBJ_UPVALUE,
+} obj_type_t;
+
+// Header shared by every heap object.
+struct obj_t {
+  obj_type_t type;
+  // Set while a collection has reached the object; clear otherwise.
+  int is_marked;
+  // Links the object into vm_t.objects, which owns it.
+  doubly_linked_node_t link;
+};
+
+/*
+  An immutable, interned string. Like string_t it caches its FNV-1a hash,
+  and the characters live inline after the header (NUL-terminated), so a
+  string is a single allocation.
+*/
+struct obj_string_t {
+  obj_t obj;
+  size_t length;
+  uint32_t hash;
+  char chars[];
+};
+
+typedef struct obj_function_t {
+  obj_t obj;
+  int arity;
+  int upvalue_count;
+  chunk_t chunk;
+  obj_string_t *name;
+} obj_function_t;
+
+typedef value_t (*native_fn_t)(int arg_count, value_t *args);
+
+typedef struct obj_native_t {
+  obj_t obj;
+  native_fn_t function;
+} obj_native_t;
+
+/*
+  A variable captured by a closure. While open, location points at the
+  variable's stack slot; closing it copies the value into closed and
+  repoints location there. Open upvalues form a list sorted by stack slot.
+*/
+typedef struct obj_upvalue_t {
+  obj_t obj;
+  value_t *location;
+  value_t closed;
+  struct obj_upvalue_t *next;
+} obj_upvalue_t;
+
+typedef struct obj_closure_t {
+  obj_t obj;
+  obj_function_t *function;
+  obj_upvalue_t **upvalues;
+  int upvalue_count;
+} obj_closure_t;
+
+typedef struct obj_class_t {
+  obj_t obj;
+  obj_string_t *name;
+  table_t methods;
+} obj_class_t;
+
+typedef struct obj_instance_t {
+  obj_t obj;
+  obj_class_t *klass;
+  table_t fields;
+} obj_instance_t;
+
+typedef struct obj_bound_method_t {
+  obj_t obj;
+  value_t receiver;
+  obj_closure_t *method;
+} obj_bound_method_t;
+
+static inline int object_is(value_t value, obj_type_t type) {
+  return value_is_obj(value) && value_as_obj(value)->type == type;
+}
+
+static inline obj_string_t *value_as_string(value_t value) {
+  return (obj_string_t *)value_as_obj(value);
+}
+
+obj_bound_method_t *object_new_bound_method(vm_t *vm, value_t receiver,
+                                            obj_closure_t *method);
+obj_class_t *object_new_class(vm_t *vm, obj_string_t *name);
+obj_closure_t *object_new_closure(vm_t *vm, obj_function_t *function);
+obj_function_t *object_new_function(vm_t *vm);
+obj_instance_t *object_new_instance(vm_t *vm, obj_class_t *klass);
+obj_native_t *object_new_native(vm_t *vm, native_fn_t function);
+obj_upvalue_t *object_new_upvalue(vm_t *vm, value_t *slot);
+
+// Returns the interned string with these characters, creating it if needed.
+obj_string_t *object_copy_string(vm_t *vm, const char *chars, size_t length);
+obj_string_t *object_concat_strings(vm_t *vm, obj_string_t *a,
+                                    obj_string_t *b);
+
+void object_print(FILE *out, value_t value);
+// The bytes the collector accounts to object: its header and inline
+// payload, not the tables or chunks it owns.
+size_t object_size(obj_t *object);
+// Frees an object that has already been unlinked from vm->objects.
+void object_free(vm_t *vm, obj_t *object);
+
+#endif // OBJECT_H
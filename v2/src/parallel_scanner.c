@@ -0,0 +1,130 @@
+#include "parallel_scanner.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct scan_chunk_t {
+  const char *start;
+  const char *end;
+  const char *limit;
+  token_t *tokens;
+  size_t count;
+  int newlines;
+  // Filled in before the merge phase.
+  token_t *destination;
+  int line_offset;
+} scan_chunk_t;
+
+static void *scan_chunk(void *arg) {
+  scan_chunk_t *chunk = arg;
+  scanner_t scanner;
+  scanner_init(&scanner, chunk->start, (size_t)(chunk->end - chunk->start));
+  // Tokens never cross a split point, but the kernels may read past it.
+  scanner.limit = chunk->limit;
+
+  // Real code averages well over four bytes per token.
+  size_t capacity = (size_t)(chunk->end - chunk->start) / 4 + 16;
+  chunk->tokens = malloc(capacity * sizeof(token_t));
+  chunk->count = 0;
+  for (;;) {
+    token_t token = scanner_scan_token(&scanner);
+    if (token.type == TOKEN_EOF) {
+      break;
+    }
+    if (chunk->count == capacity) {
+      capacity *= 2;
+      chunk->tokens = realloc(chunk->tokens, capacity * sizeof(token_t));
+    }
+    chunk->tokens[chunk->count++] = token;
+  }
+  chunk->newlines = scanner.line - 1;
+  return NULL;
+}
+
+static void *merge_chunk(void *arg) {
+  scan_chunk_t *chunk = arg;
+  if (chunk->destination == chunk->tokens) {
+    return NULL;
+  }
+  for (size_t i = 0; i < chunk->count; i++) {
+    token_t token = chunk->tokens[i];
+    token.line += chunk->line_offset;
+    chunk->destination[i] = token;
+  }
+  free(chunk->tokens);
+  return NULL;
+}
+
+// Runs work on every chunk, using the calling thread for the first one.
+// A chunk whose worker could not be started (say, EAGAIN at a thread
+// limit) is run on the calling thread too.
+static void run_chunks(scan_chunk_t *chunks, size_t count,
+                       void *(*work)(void *)) {
+  pthread_t workers[count];
+  int started[count];
+  for (size_t i = 1; i < count; i++) {
+    started[i] = pthread_create(&workers[i], NULL, work, &chunks[i]) == 0;
+  }
+  work(&chunks[0]);
+  for (size_t i = 1; i < count; i++) {
+    if (started[i]) {
+      pthread_join(workers[i], NULL);
+    } else {
+      work(&chunks[i]);
+    }
+  }
+}
+
+token_stream_t *parallel_scanner_scan(const char *source, size_t length,
+                                      int threads) {
+  size_t count = threads > 0 ? (size_t)threads : 1;
+  if (length / PARALLEL_SCANNER_MIN_CHUNK < count) {
+    count = length / PARALLEL_SCANNER_MIN_CHUNK > 0
+                ? length / PARALLEL_SCANNER_MIN_CHUNK
+                : 1;
+  }
+  const char *bounds[count + 1];
+  count = scanner_split(source, length, count, bounds);
+
+  scan_chunk_t chunks[count];
+  for (size_t i = 0; i < count; i++) {
+    chunks[i].start = bounds[i];
+    chunks[i].end = bounds[i + 1];
+    chunks[i].limit = source + length;
+  }
+  run_chunks(chunks, count, scan_chunk);
+
+  size_t total = 1;
+  int lines = 0;
+  for (size_t i = 0; i < count; i++) {
+    chunks[i].line_offset = lines;
+    total += chunks[i].count;
+    lines += chunks[i].newlines;
+  }
+
+  // The first chunk's tokens need no shifting, so its array becomes the
+  // stream and only the later chunks are copied in behind it.
+  token_stream_t *stream = malloc(sizeof(token_stream_t));
+  stream->tokens = realloc(chunks[0].tokens, total * sizeof(token_t));
+  stream->count = total;
+  chunks[0].tokens = stream->tokens;
+  token_t *destination = stream->tokens;
+  for (size_t i = 0; i < count; i++) {
+    chunks[i].destination = destination;
+    destination += chunks[i].count;
+  }
+  if (count > 1) {
+    run_chunks(chunks, count, merge_chunk);
+  }
+
+  *destination = (token_t){.type = TOKEN_EOF,
+                           .start = source + length,
+                           .length = 0,
+                           .line = lines + 1};
+  return stream;
+}
+
+void token_stream_free(token_stream_t *stream) {
+  free(stream->tokens);
+  free(stream);
+}
@@ -0,0 +1,26 @@
+#ifndef PARALLEL_SCANNER_H
+#define PARALLEL_SCANNER_H
+
+#include "scanner.h"
+
+// Sources are not split into chunks smaller than this.
+#define PARALLEL_SCANNER_MIN_CHUNK 16384
+
+typedef struct token_stream_t {
+  token_t *tokens;
+  // Includes the final EOF token.
+  size_t count;
+} token_stream_t;
+
+/*
+  Scans the whole source into one token array, splitting it at safe
+  newlines (see scanner_split) and lexing up to threads chunks at once. Each
+  chunk counts lines from 1; the merge shifts them by the newlines of the
+  chunks before it, so the stream is identical to what scanner_scan_token
+  returns for the unsplit source.
+*/
+token_stream_t *parallel_scanner_scan(const char *source, size_t length,
+                                      int threads);
+void token_stream_free(token_stream_t *stream);
+
+#endif // PARALLEL_SCANNER_H
@@ -0,0 +1,602 @@
+#include "scanner.h"
+#include <string.h>
+
+#ifdef __SSE2__
+#include <immintrin.h>
+#include <pthread.h>
+#define SCANNER_X86 1
+#endif
+
+#define SCANNER_SCALAR_PRELUDE 16
+
+enum {
+  CHAR_ALPHA = 1 << 0,
+  CHAR_DIGIT = 1 << 1,
+  CHAR_SPACE = 1 << 2,
+};
+
+static const unsigned char char_class[256] = {
+    ['a' ... 'z'] = CHAR_ALPHA, ['A' ... 'Z'] = CHAR_ALPHA,
+    ['_'] = CHAR_ALPHA,         ['0' ... '9'] = CHAR_DIGIT,
+    [' '] = CHAR_SPACE,         ['\r'] = CHAR_SPACE,
+    ['\t'] = CHAR_SPACE,
+};
+
+static const char *token_type_names[] = {
+    [TOKEN_LEFT_PAREN] = "LEFT_PAREN",
+    [TOKEN_RIGHT_PAREN] = "RIGHT_PAREN",
+    [TOKEN_LEFT_BRACE] = "LEFT_BRACE",
+    [TOKEN_RIGHT_BRACE] = "RIGHT_BRACE",
+    [TOKEN_COMMA] = "COMMA",
+    [TOKEN_DOT] = "DOT",
+    [TOKEN_MINUS] = "MINUS",
+    [TOKEN_PLUS] = "PLUS",
+    [TOKEN_SEMICOLON] = "SEMICOLON",
+    [TOKEN_SLASH] = "SLASH",
+    [TOKEN_STAR] = "STAR",
+    [TOKEN_BANG] = "BANG",
+    [TOKEN_BANG_EQUAL] = "BANG_EQUAL",
+    [TOKEN_EQUAL] = "EQUAL",
+    [TOKEN_EQUAL_EQUAL] = "EQUAL_EQUAL",
+    [TOKEN_GREATER] = "GREATER",
+    [TOKEN_GREATER_EQUAL] = "GREATER_EQUAL",
+    [TOKEN_LESS] = "LESS",
+    [TOKEN_LESS_EQUAL] = "LESS_EQUAL",
+    [TOKEN_IDENTIFIER] = "IDENTIFIER",
+    [TOKEN_STRING] = "STRING",
+    [TOKEN_NUMBER] = "NUMBER",
+    [TOKEN_AND] = "AND",
+    [TOKEN_CLASS] = "CLASS",
+    [TOKEN_ELSE] = "ELSE",
+    [TOKEN_FALSE] = "FALSE",
+    [TOKEN_FUN] = "FUN",
+    [TOKEN_FOR] = "FOR",
+    [TOKEN_IF] = "IF",
+    [TOKEN_NIL] = "NIL",
+    [TOKEN_OR] = "OR",
+    [TOKEN_PRINT] = "PRINT",
+    [TOKEN_RETURN] = "RETURN",
+    [TOKEN_SUPER] = "SUPER",
+    [TOKEN_THIS] = "THIS",
+    [TOKEN_TRUE] = "TRUE",
+    [TOKEN_VAR] = "VAR",
+    [TOKEN_WHILE] = "WHILE",
+    [TOKEN_ERROR] = "ERROR",
+    [TOKEN_EOF] = "EOF",
+};
+
+void scanner_init(scanner_t *scanner, const char *source, size_t length) {
+  scanner->start = source;
+  scanner->current = source;
+  scanner->end = source + length;
+  scanner->limit = scanner->end;
+  scanner->line = 1;
+}
+
+void scanner_init_padded(scanner_t *scanner, const char *source,
+                         size_t length) {
+  scanner_init(scanner, source, length);
+  scanner->limit = scanner->end + SCANNER_PADDING;
+}
+
+const char *scanner_token_type_name(token_type_t type) {
+  return token_type_names[type];
+}
+
+static int is_at_end(scanner_t *scanner) {
+  return scanner->current >= scanner->end;
+}
+
+static char peek(scanner_t *scanner) {
+  return is_at_end(scanner) ? '\0' : *scanner->current;
+}
+
+static char peek_next(scanner_t *scanner) {
+  return scanner->current + 1 >= scanner->end ? '\0' : scanner->current[1];
+}
+
+static int match(scanner_t *scanner, char expected) {
+  if (is_at_end(scanner) || *scanner->current != expected) {
+    return 0;
+  }
+  scanner->current++;
+  return 1;
+}
+
+static int has_class(char c, unsigned char class) {
+  return char_class[(unsigned char)c] & class;
+}
+
+/*
+  The loops that dominate scanning time -- whitespace runs, comment bodies,
+  string bodies and identifier tails -- run through the kernels below. Each
+  returns the first byte that ends the run (or end) and adds the newlines it
+  stepped over to *lines. On x86 they compare 16 (SSE2) or 32 (AVX2) bytes
+  at a time and count newlines with a popcount of the '\n' mask; the scalar
+  versions finish the tail and serve other targets.
+*/
+static const char *skip_blank_scalar(const char *p, const char *end,
+                                     int *lines) {
+  for (; p < end; p++) {
+    if (*p == '\n') {
+      (*lines)++;
+    } else if (!has_class(*p, CHAR_SPACE)) {
+      break;
+    }
+  }
+  return p;
+}
+
+static const char *find_either_scalar(const char *p, const char *end, char a,
+                                      char b, int *lines) {
+  for (; p < end && *p != a && *p != b; p++) {
+    if (*p == '\n') {
+      (*lines)++;
+    }
+  }
+  return p;
+}
+
+static const char *span_identifier_scalar(const char *p, const char *end) {
+  while (p < end && has_class(*p, CHAR_ALPHA | CHAR_DIGIT)) {
+    p++;
+  }
+  return p;
+}
+
+#ifdef SCANNER_X86
+
+// Newlines among the bytes before the first set bit of stop.
+static inline int newlines_before(unsigned newlines, unsigned stop) {
+  return __builtin_popcount(newlines & ((stop & -stop) - 1));
+}
+
+static const char *skip_blank_sse2(const char *p, const char *end,
+                                   int *lines) {
+  for (; end - p >= 16; p += 16) {
+    __m128i block = _mm_loadu_si128((const __m128i *)p);
+    __m128i newline = _mm_cmpeq_epi8(block, _mm_set1_epi8('\n'));
+    __m128i blank = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(' ')),
+                     _mm_cmpeq_epi8(block, _mm_set1_epi8('\t'))),
+        _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('\r')), newline));
+    unsigned newlines = _mm_movemask_epi8(newline);
+    unsigned stop = ~_mm_movemask_epi8(blank) & 0xffff;
+    if (stop != 0) {
+      *lines += newlines_before(newlines, stop);
+      return p + __builtin_ctz(stop);
+    }
+    *lines += __builtin_popcount(newlines);
+  }
+  return skip_blank_scalar(p, end, lines);
+}
+
+static const char *find_either_sse2(const char *p, const char *end, char a,
+                                    char b, int *lines) {
+  const __m128i first = _mm_set1_epi8(a);
+  const __m128i second = _mm_set1_epi8(b);
+  for (; end - p >= 16; p += 16) {
+    __m128i block = _mm_loadu_si128((const __m128i *)p);
+    unsigned newlines =
+        _mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8('\n')));
+    unsigned stop = _mm_movemask_epi8(_mm_or_si128(
+        _mm_cmpeq_epi8(block, first), _mm_cmpeq_epi8(block, second)));
+    if (stop != 0) {
+      *lines += newlines_before(newlines, stop);
+      return p + __builtin_ctz(stop);
+    }
+    *lines += __builtin_popcount(newlines);
+  }
+  return find_either_scalar(p, end, a, b, lines);
+}
+
+// A byte is in [lo, lo + span] when min(byte - lo, span) == byte - lo.
+static inline __m128i in_range_sse2(__m128i block, char lo, char span) {
+  __m128i offset = _mm_sub_epi8(block, _mm_set1_epi8(lo));
+  return _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(span)), offset);
+}
+
+static const char *span_identifier_sse2(const char *p, const char *end) {
+  for (; end - p >= 16; p += 16) {
+    __m128i block = _mm_loadu_si128((const __m128i *)p);
+    __m128i word = _mm_or_si128(
+        _mm_or_si128(
+            in_range_sse2(_mm_or_si128(block, _mm_set1_epi8(0x20)), 'a', 25),
+            in_range_sse2(block, '0', 9)),
+        _mm_cmpeq_epi8(block, _mm_set1_epi8('_')));
+    unsigned stop = ~_mm_movemask_epi8(word) & 0xffff;
+    if (stop != 0) {
+      return p + __builtin_ctz(stop);
+    }
+  }
+  return span_identifier_scalar(p, end);
+}
+
+__attribute__((target("avx2"))) static const char *
+skip_blank_avx2(const char *p, const char *end, int *lines) {
+  for (; end - p >= 32; p += 32) {
+    __m256i block = _mm256_loadu_si256((const __m256i *)p);
+    __m256i newline = _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\n'));
+    __m256i blank = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(' ')),
+                        _mm256_cmpeq_epi8(block, _mm256_set1_epi8('\t'))),
+        _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('\r')),
+                        newline));
+    unsigned newlines = _mm256_movemask_epi8(newline);
+    unsigned stop = ~_mm256_movemask_epi8(blank);
+    if (stop != 0) {
+      *lines += newlines_before(newlines, stop);
+      return p + __builtin_ctz(stop);
+    }
+    *lines += __builtin_popcount(newlines);
+  }
+  return skip_blank_sse2(p, end, lines);
+}
+
+__attribute__((target("avx2"))) static const char *
+find_either_avx2(const char *p, const char *end, char a, char b, int *lines) {
+  const __m256i first = _mm256_set1_epi8(a);
+  const __m256i second = _mm256_set1_epi8(b);
+  for (; end - p >= 32; p += 32) {
+    __m256i block = _mm256_loadu_si256((const __m256i *)p);
+    unsigned newlines =
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('\n')));
+    unsigned stop = _mm256_movemask_epi8(_mm256_or_si256(
+        _mm256_cmpeq_epi8(block, first), _mm256_cmpeq_epi8(block, second)));
+    if (stop != 0) {
+      *lines += newlines_before(newlines, stop);
+      return p + __builtin_ctz(stop);
+    }
+    *lines += __builtin_popcount(newlines);
+  }
+  return find_either_sse2(p, end, a, b, lines);
+}
+
+// Resolved once: the parallel scanner runs the kernels on several threads.
+static int has_avx2 = 0;
+static pthread_once_t has_avx2_resolved = PTHREAD_ONCE_INIT;
+
+static void resolve_avx2(void) {
+  has_avx2 = __builtin_cpu_supports("avx2") ? 1 : 0;
+}
+
+static int use_avx2(void) {
+  pthread_once(&has_avx2_resolved, resolve_avx2);
+  return has_avx2;
+}
+
+/*
+  Most runs in real code are a few bytes long -- a single space, a short
+  name -- and entering a vector loop for those costs more than it saves. The
+  dispatchers below therefore walk the first SCANNER_SCALAR_PRELUDE bytes
+  with the scalar loops and only hand longer runs to the kernels.
+*/
+static inline const char *prelude_end(const char *p, const char *end) {
+  return end - p > SCANNER_SCALAR_PRELUDE ? p + SCANNER_SCALAR_PRELUDE : end;
+}
+
+// The kernels may read up to limit, counting newlines as they go; a run can
+// still only end at end, so newlines counted past it are taken back.
+static inline const char *clamp(scanner_t *scanner, const char *p) {
+  if (p <= scanner->end) {
+    return p;
+  }
+  for (const char *c = scanner->end; c < p; c++) {
+    scanner->line -= *c == '\n';
+  }
+  return scanner->end;
+}
+
+static const char *skip_blank(scanner_t *scanner, const char *p) {
+  const char *stop = prelude_end(p, scanner->end);
+  p = skip_blank_scalar(p, stop, &scanner->line);
+  if (p < stop || p == scanner->end) {
+    return p;
+  }
+  return clamp(scanner,
+               use_avx2() ? skip_blank_avx2(p, scanner->limit, &scanner->line)
+                          : skip_blank_sse2(p, scanner->limit, &scanner->line));
+}
+
+static const char *find_either(scanner_t *scanner, const char *p, char a,
+                               char b) {
+  const char *stop = prelude_end(p, scanner->end);
+  p = find_either_scalar(p, stop, a, b, &scanner->line);
+  if (p < stop || p == scanner->end) {
+    return p;
+  }
+  return clamp(
+      scanner,
+      use_avx2() ? find_either_avx2(p, scanner->limit, a, b, &scanner->line)
+                 : find_either_sse2(p, scanner->limit, a, b, &scanner->line));
+}
+
+// Identifiers rarely outgrow one 16-byte block, so AVX2 would not pay off.
+static const char *span_identifier(scanner_t *scanner, const char *p) {
+  const char *stop = prelude_end(p, scanner->end);
+  p = span_identifier_scalar(p, stop);
+  if (p < stop || p == scanner->end) {
+    return p;
+  }
+  return clamp(scanner, span_identifier_sse2(p, scanner->limit));
+}
+
+#else
+
+static const char *skip_blank(scanner_t *scanner, const char *p) {
+  return skip_blank_scalar(p, scanner->end, &scanner->line);
+}
+
+static const char *find_either(scanner_t *scanner, const char *p, char a,
+                               char b) {
+  return find_either_scalar(p, scanner->end, a, b, &scanner->line);
+}
+
+static const char *span_identifier(scanner_t *scanner, const char *p) {
+  return span_identifier_scalar(p, scanner->end);
+}
+
+#endif
+
+static token_t make_token(scanner_t *scanner, token_type_t type, int line) {
+  return (token_t){.type = type,
+                   .start = scanner->start,
+                   .length = (size_t)(scanner->current - scanner->start),
+                   .line = line};
+}
+
+static token_t error_token(const char *message, int line) {
+  return (token_t){.type = TOKEN_ERROR,
+                   .start = message,
+                   .length = strlen(message),
+                   .line = line};
+}
+
+/*
+  Block comments nest, so each opener inside one needs its own closer.
+  Returns 0, with current at the end of the source, when one is unterminated.
+*/
+static int skip_block_comment(scanner_t *scanner) {
+  const char *p = scanner->current + 2;
+  int depth = 1;
+  while (depth > 0) {
+    p = find_either(scanner, p, '*', '/');
+    if (scanner->end - p < 2) {
+      scanner->current = scanner->end;
+      return 0;
+    }
+    if (p[0] == '*' && p[1] == '/') {
+      depth--;
+      p += 2;
+    } else if (p[0] == '/' && p[1] == '*') {
+      depth++;
+      p += 2;
+    } else {
+      p++;
+    }
+  }
+  scanner->current = p;
+  return 1;
+}
+
+// Skips whitespace and comments; returns an error message or NULL.
+static const char *skip_whitespace(scanner_t *scanner) {
+  for (;;) {
+    scanner->current = skip_blank(scanner, scanner->current);
+    if (peek(scanner) != '/') {
+      return NULL;
+    }
+    char next = peek_next(scanner);
+    if (next == '/') {
+      scanner->current =
+          find_either(scanner, scanner->current + 2, '\n', '\n');
+    } else if (next == '*') {
+      if (!skip_block_comment(scanner)) {
+        return "Unterminated block comment.";
+      }
+    } else {
+      return NULL;
+    }
+  }
+}
+
+static token_type_t check_keyword(scanner_t *scanner, size_t offset,
+                                  size_t length, const char *rest,
+                                  token_type_t type) {
+  if ((size_t)(scanner->current - scanner->start) == offset + length &&
+      memcmp(scanner->start + offset, rest, length) == 0) {
+    return type;
+  }
+  return TOKEN_IDENTIFIER;
+}
+
+// A trie over the keyword set, unrolled into switches on the leading bytes.
+static token_type_t identifier_type(scanner_t *scanner) {
+  size_t length = (size_t)(scanner->current - scanner->start);
+  switch (scanner->start[0]) {
+  case 'a':
+    return check_keyword(scanner, 1, 2, "nd", TOKEN_AND);
+  case 'c':
+    return check_keyword(scanner, 1, 4, "lass", TOKEN_CLASS);
+  case 'e':
+    return check_keyword(scanner, 1, 3, "lse", TOKEN_ELSE);
+  case 'f':
+    if (length > 1) {
+      switch (scanner->start[1]) {
+      case 'a':
+        return check_keyword(scanner, 2, 3, "lse", TOKEN_FALSE);
+      case 'o':
+        return check_keyword(scanner, 2, 1, "r", TOKEN_FOR);
+      case 'u':
+        return check_keyword(scanner, 2, 1, "n", TOKEN_FUN);
+      }
+    }
+    break;
+  case 'i':
+    return check_keyword(scanner, 1, 1, "f", TOKEN_IF);
+  case 'n':
+    return check_keyword(scanner, 1, 2, "il", TOKEN_NIL);
+  case 'o':
+    return check_keyword(scanner, 1, 1, "r", TOKEN_OR);
+  case 'p':
+    return check_keyword(scanner, 1, 4, "rint", TOKEN_PRINT);
+  case 'r':
+    return check_keyword(scanner, 1, 5, "eturn", TOKEN_RETURN);
+  case 's':
+    return check_keyword(scanner, 1, 4, "uper", TOKEN_SUPER);
+  case 't':
+    if (length > 1) {
+      switch (scanner->start[1]) {
+      case 'h':
+        return check_keyword(scanner, 2, 2, "is", TOKEN_THIS);
+      case 'r':
+        return check_keyword(scanner, 2, 2, "ue", TOKEN_TRUE);
+      }
+    }
+    break;
+  case 'v':
+    return check_keyword(scanner, 1, 2, "ar", TOKEN_VAR);
+  case 'w':
+    return check_keyword(scanner, 1, 4, "hile", TOKEN_WHILE);
+  }
+  return TOKEN_IDENTIFIER;
+}
+
+static token_t identifier(scanner_t *scanner, int line) {
+  scanner->current = span_identifier(scanner, scanner->current);
+  return make_token(scanner, identifier_type(scanner), line);
+}
+
+static token_t number_literal(scanner_t *scanner, int line) {
+  while (has_class(peek(scanner), CHAR_DIGIT)) {
+    scanner->current++;
+  }
+  if (peek(scanner) == '.' && has_class(peek_next(scanner), CHAR_DIGIT)) {
+    scanner->current++;
+    while (has_class(peek(scanner), CHAR_DIGIT)) {
+      scanner->current++;
+    }
+  }
+  return make_token(scanner, TOKEN_NUMBER, line);
+}
+
+static token_t string_literal(scanner_t *scanner, int line) {
+  scanner->current = find_either(scanner, scanner->current, '"', '"');
+  if (is_at_end(scanner)) {
+    return error_token("Unterminated string.", line);
+  }
+  scanner->current++;
+  return make_token(scanner, TOKEN_STRING, line);
+}
+
+token_t scanner_scan_token(scanner_t *scanner) {
+  const char *error = skip_whitespace(scanner);
+  scanner->start = scanner->current;
+  int line = scanner->line;
+  if (error != NULL) {
+    return error_token(error, line);
+  }
+  if (is_at_end(scanner)) {
+    return make_token(scanner, TOKEN_EOF, line);
+  }
+
+  char c = *scanner->current++;
+  if (has_class(c, CHAR_ALPHA)) {
+    return identifier(scanner, line);
+  }
+  if (has_class(c, CHAR_DIGIT)) {
+    return number_literal(scanner, line);
+  }
+
+  switch (c) {
+  case '(':
+    return make_token(scanner, TOKEN_LEFT_PAREN, line);
+  case ')':
+    return make_token(scanner, TOKEN_RIGHT_PAREN, line);
+  case '{':
+    return make_token(scanner, TOKEN_LEFT_BRACE, line);
+  case '}':
+    return make_token(scanner, TOKEN_RIGHT_BRACE, line);
+  case ',':
+    return make_token(scanner, TOKEN_COMMA, line);
+  case '.':
+    return make_token(scanner, TOKEN_DOT, line);
+  case '-':
+    return make_token(scanner, TOKEN_MINUS, line);
+  case '+':
+    return make_token(scanner, TOKEN_PLUS, line);
+  case ';':
+    return make_token(scanner, TOKEN_SEMICOLON, line);
+  case '/':
+    return make_token(scanner, TOKEN_SLASH, line);
+  case '*':
+    return make_token(scanner, TOKEN_STAR, line);
+  case '!':
+    return make_token(
+        scanner, match(scanner, '=') ? TOKEN_BANG_EQUAL : TOKEN_BANG, line);
+  case '=':
+    return make_token(
+        scanner, match(scanner, '=') ? TOKEN_EQUAL_EQUAL : TOKEN_EQUAL, line);
+  case '<':
+    return make_token(
+        scanner, match(scanner, '=') ? TOKEN_LESS_EQUAL : TOKEN_LESS, line);
+  case '>':
+    return make_token(scanner,
+                      match(scanner, '=') ? TOKEN_GREATER_EQUAL : TOKEN_GREATER,
+                      line);
+  case '"':
+    return string_literal(scanner, line);
+  }
+  return error_token("Unexpected character.", line);
+}
+
+size_t scanner_split(const char *source, size_t length, size_t count,
+                     const char **bounds) {
+  scanner_t scanner;
+  scanner_init(&scanner, source, length);
+  const char *end = scanner.end;
+  const char *p = source;
+  size_t chunks = 1;
+  bounds[0] = source;
+
+  // [p, q) never holds a string or comment, so any newline in it is safe.
+  while (chunks < count) {
+    const char *target = source + length * chunks / count;
+    const char *q = find_either(&scanner, p, '"', '/');
+    if (q > target) {
+      const char *from = p > target ? p : target;
+      const char *newline = memchr(from, '\n', (size_t)(q - from));
+      if (newline != NULL) {
+        if (newline + 1 >= end) {
+          break;
+        }
+        bounds[chunks++] = newline + 1;
+        p = newline + 1;
+        continue;
+      }
+    }
+    if (q >= end) {
+      break;
+    }
+    if (*q == '"') {
+      p = find_either(&scanner, q + 1, '"', '"');
+      if (p >= end) {
+        break;
+      }
+      p++;
+    } else if (q + 1 < end && q[1] == '/') {
+      p = find_either(&scanner, q + 2, '\n', '\n');
+    } else if (q + 1 < end && q[1] == '*') {
+      scanner.current = q;
+      if (!skip_block_comment(&scanner)) {
+        break;
+      }
+      p = scanner.current;
+    } else {
+      p = q + 1;
+    }
+  }
+
+  bounds[chunks] = end;
+  return chunks;
+}
@@ -0,0 +1,110 @@
+#ifndef SCANNER_H
+#define SCANNER_H
+
+#include <stddef.h>
+
+typedef enum token_type_t {
+  // Single-character tokens.
+  TOKEN_LEFT_PAREN,
+  TOKEN_RIGHT_PAREN,
+  TOKEN_LEFT_BRACE,
+  TOKEN_RIGHT_BRACE,
+  TOKEN_COMMA,
+  TOKEN_DOT,
+  TOKEN_MINUS,
+  TOKEN_PLUS,
+  TOKEN_SEMICOLON,
+  TOKEN_SLASH,
+  TOKEN_STAR,
+
+  // One or two character tokens.
+  TOKEN_BANG,
+  TOKEN_BANG_EQUAL,
+  TOKEN_EQUAL,
+  TOKEN_EQUAL_EQUAL,
+  TOKEN_GREATER,
+  TOKEN_GREATER_EQUAL,
+  TOKEN_LESS,
+  TOKEN_LESS_EQUAL,
+
+  // Literals.
+  TOKEN_IDENTIFIER,
+  TOKEN_STRING,
+  TOKEN_NUMBER,
+
+  // Keywords.
+  TOKEN_AND,
+  TOKEN_CLASS,
+  TOKEN_ELSE,
+  TOKEN_FALSE,
+  TOKEN_FUN,
+  TOKEN_FOR,
+  TOKEN_IF,
+  TOKEN_NIL,
+  TOKEN_OR,
+  TOKEN_PRINT,
+  TOKEN_RETURN,
+  TOKEN_SUPER,
+  TOKEN_THIS,
+  TOKEN_TRUE,
+  TOKEN_VAR,
+  TOKEN_WHILE,
+
+  // start points at a static message instead of into the source.
+  TOKEN_ERROR,
+  TOKEN_EOF
+} token_type_t;
+
+/*
+  A view into the source buffer: nothing is copied, so a token is only valid
+  while the source is. STRING tokens include their quotes, and line is the
+  line the token starts on.
+*/
+typedef struct token_t {
+  token_type_t type;
+  // Kept next to type so the struct packs into 24 bytes.
+  int line;
+  const char *start;
+  size_t length;
+} token_t;
+
+// Zero bytes a padded source must have readable after its last byte.
+#define SCANNER_PADDING 32
+
+typedef struct scanner_t {
+  const char *start;
+  const char *current;
+  const char *end;
+  // How far the vector kernels may read: end, or end + SCANNER_PADDING.
+  const char *limit;
+  int line;
+} scanner_t;
+
+void scanner_init(scanner_t *scanner, const char *source, size_t length);
+
+/*
+  For sources followed by SCANNER_PADDING zero bytes (see source_open). The
+  zero sentinel ends every whitespace and identifier run, so the vector loops
+  run straight into the padding instead of finishing the last bytes of the
+  source one at a time.
+*/
+void scanner_init_padded(scanner_t *scanner, const char *source,
+                         size_t length);
+
+// Scans the next token on demand; returns EOF (repeatedly) at the end.
+token_t scanner_scan_token(scanner_t *scanner);
+
+const char *scanner_token_type_name(token_type_t type);
+
+/*
+  Picks up to count - 1 split points near even fractions of the source, each
+  just after a newline that lies outside every string and block comment, so
+  a fresh scanner started there produces exactly the tokens a single scanner
+  would. Fills bounds[0..chunks] (bounds[0] is source and bounds[chunks] the
+  end) and returns chunks, which is smaller than count when the source has
+  too few safe newlines.
+*/
+size_t scanner_split(const char *source, size_t length, size_t count,
+                     const char **bounds);
+
+#endif // SCANNER_H
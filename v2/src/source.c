@@ -0,0 +1,105 @@
+#include "source.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SOURCE_READ_SIZE 65536
+
+static size_t round_to_page(size_t size, size_t page) {
+  return (size + page - 1) & ~(page - 1);
+}
+
+/*
+  Reserves zeroed anonymous pages for the text and its padding, then maps the
+  file over the front of them. The kernel zero-fills the rest of the file's
+  last page, and the anonymous pages past it are zero too, so the padding
+  exists even when the file ends exactly on a page boundary.
+*/
+static source_t *source_map(int fd, size_t length) {
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  size_t size = round_to_page(length + SCANNER_PADDING, page);
+  char *text =
+      mmap(NULL, size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (text == MAP_FAILED) {
+    return NULL;
+  }
+  size_t file_size = round_to_page(length, page);
+  if (mmap(text, file_size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) ==
+      MAP_FAILED) {
+    munmap(text, size);
+    return NULL;
+  }
+  madvise(text, file_size, MADV_SEQUENTIAL);
+
+  source_t *source = malloc(sizeof(source_t));
+  source->text = text;
+  source->length = length;
+  source->mapped = size;
+  return source;
+}
+
+source_t *source_read_fd(int fd) {
+  size_t capacity = SOURCE_READ_SIZE;
+  size_t length = 0;
+  char *text = malloc(capacity);
+  for (;;) {
+    if (capacity - length < SOURCE_READ_SIZE + SCANNER_PADDING) {
+      capacity *= 2;
+      text = realloc(text, capacity);
+    }
+    ssize_t count = read(fd, text + length, SOURCE_READ_SIZE);
+    if (count == 0) {
+      break;
+    }
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      int error = errno;
+      free(text);
+      errno = error;
+      return NULL;
+    }
+    length += (size_t)count;
+  }
+  memset(text + length, 0, SCANNER_PADDING);
+
+  source_t *source = malloc(sizeof(source_t));
+  source->text = text;
+  source->length = length;
+  source->mapped = 0;
+  return source;
+}
+
+source_t *source_open(const char *path) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return NULL;
+  }
+  struct stat info;
+  source_t *source = NULL;
+  // Files that report no size (procfs and the like) may still have content.
+  if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+    source = source_map(fd, (size_t)info.st_size);
+  }
+  if (source == NULL) {
+    source = source_read_fd(fd);
+  }
+  int error = errno;
+  close(fd);
+  errno = error;
+  return source;
+}
+
+void source_free(source_t *source) {
+  if (source->mapped > 0) {
+    munmap((void *)source->text, source->mapped);
+  } else {
+    free((void *)source->text);
+  }
+  free(source);
+}
@@ -0,0 +1,26 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include "scanner.h"
+#include <stddef.h>
+
+/*
+  A script's bytes followed by at least SCANNER_PADDING zero bytes, ready for
+  scanner_init_padded. Regular files are mapped read-only, so opening one
+  costs the same whatever its size and pages are read in as the scanner
+  reaches them. Pipes, terminals and other streams are read into a heap
+  buffer instead.
+*/
+typedef struct source_t {
+  const char *text;
+  size_t length;
+  // Size of the mapping, or 0 when text is a heap buffer.
+  size_t mapped;
+} source_t;
+
+// Returns NULL and leaves errno set when the file cannot be read.
+source_t *source_open(const char *path);
+source_t *source_read_fd(int fd);
+void source_free(source_t *source);
+
+#endif // SOURCE_H
@@ -0,0 +1,164 @@
+#include "table.h"
+#include "object.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TABLE_MIN_CAPACITY 8
+
+void table_init(table_t *table) {
+  table->entries = NULL;
+  table->count = 0;
+  table->tombstones = 0;
+  table->capacity = 0;
+  table->max_load = TABLE_MAX_LOAD;
+}
+
+void table_free(table_t *table) {
+  free(table->entries);
+  table->entries = NULL;
+  table->count = 0;
+  table->tombstones = 0;
+  table->capacity = 0;
+}
+
+// The bucket holding key, or the one to insert it into: the first
+// tombstone passed, else the empty bucket that ended the probe.
+static table_entry_t *find_entry(table_entry_t *entries, size_t capacity,
+                                 obj_string_t *key) {
+  size_t mask = capacity - 1;
+  size_t index = key->hash & mask;
+  table_entry_t *tombstone = NULL;
+  for (;;) {
+    table_entry_t *entry = &entries[index];
+    if (entry->key == key) {
+      return entry;
+    }
+    if (entry->key == NULL) {
+      if (value_is_nil(entry->value)) {
+        return tombstone != NULL ? tombstone : entry;
+      }
+      if (tombstone == NULL) {
+        tombstone = entry;
+      }
+    }
+    index = (index + 1) & mask;
+  }
+}
+
+static void adjust_capacity(table_t *table, size_t capacity) {
+  table_entry_t *entries = malloc(capacity * sizeof(table_entry_t));
+  for (size_t i = 0; i < capacity; i++) {
+    entries[i].key = NULL;
+    entries[i].value = value_nil();
+  }
+
+  // Tombstones are dropped, so count is recomputed.
+  table->count = 0;
+  table->tombstones = 0;
+  for (size_t i = 0; i < table->capacity; i++) {
+    table_entry_t *entry = &table->entries[i];
+    if (entry->key == NULL) {
+      continue;
+    }
+    table_entry_t *dest = find_entry(entries, capacity, entry->key);
+    dest->key = entry->key;
+    dest->value = entry->value;
+    table->count++;
+  }
+
+  free(table->entries);
+  table->entries = entries;
+  table->capacity = capacity;
+}
+
+int table_get(table_t *table, obj_string_t *key, value_t *value) {
+  if (table->count == 0) {
+    return 0;
+  }
+  table_entry_t *entry = find_entry(table->entries, table->capacity, key);
+  if (entry->key == NULL) {
+    return 0;
+  }
+  *value = entry->value;
+  return 1;
+}
+
+int table_set(table_t *table, obj_string_t *key, value_t value) {
+  size_t limit = table->capacity * (size_t)table->max_load;
+  if ((table->count + 1) * 100 > limit) {
+    size_t live = table->count - table->tombstones;
+    size_t capacity = table->capacity;
+    if (capacity < TABLE_MIN_CAPACITY) {
+      capacity = TABLE_MIN_CAPACITY;
+    } else if ((live + 1) * 200 > limit) {
+      capacity *= 2;
+    }
+    adjust_capacity(table, capacity);
+  }
+
+  table_entry_t *entry = find_entry(table->entries, table->capacity, key);
+  int is_new = entry->key == NULL;
+  if (is_new && value_is_nil(entry->value)) {
+    table->count++;
+  } else if (is_new) {
+    // Reusing a tombstone: it was already counted.
+    table->tombstones--;
+  }
+  entry->key = key;
+  entry->value = value;
+  return is_new;
+}
+
+int table_delete(table_t *table, obj_string_t *key) {
+  if (table->count == 0) {
+    return 0;
+  }
+  table_entry_t *entry = find_entry(table->entries, table->capacity, key);
+  if (entry->key == NULL) {
+    return 0;
+  }
+  entry->key = NULL;
+  entry->value = value_bool(1);
+  table->tombstones++;
+  return 1;
+}
+
+void table_add_all(table_t *from, table_t *to) {
+  for (size_t i = 0; i < from->capacity; i++) {
+    table_entry_t *entry = &from->entries[i];
+    if (entry->key != NULL) {
+      table_set(to, entry->key, entry->value);
+    }
+  }
+}
+
+void table_remove_unmarked(table_t *table) {
+  for (size_t i = 0; i < table->capacity; i++) {
+    table_entry_t *entry = &table->entries[i];
+    if (entry->key != NULL && !entry->key->obj.is_marked) {
+      table_delete(table, entry->key);
+    }
+  }
+}
+
+obj_string_t *table_find_string(table_t *table, const char *chars,
+                                size_t length, uint32_t hash) {
+  if (table->count == 0) {
+    return NULL;
+  }
+  size_t mask = table->capacity - 1;
+  size_t index = hash & mask;
+  for (;;) {
+    table_entry_t *entry = &table->entries[index];
+    if (entry->key == NULL) {
+      // Stop at an empty bucket, but probe past tombstones.
+      if (value_is_nil(entry->value)) {
+        return NULL;
+      }
+    } else if (entry->key->hash == hash && entry->key->length == length &&
+               memcmp(entry->key->chars, chars, length) == 0) {
+      return entry->key;
+    }
+    index = (index + 1) & mask;
+  }
+}
@@ -0,0 +1,54 @@
+#ifndef TABLE_H
+#define TABLE_H
+
+#include "value.h"
+#include <stdint.h>
+
+// Default maximum load, in percent, before a table grows.
+#ifndef TABLE_MAX_LOAD
+#define TABLE_MAX_LOAD 75
+#endif
+
+// An empty bucket has no key and a nil value; a tombstone has no key and
+// a true value, so probe sequences run past deleted entries.
+typedef struct table_entry_t {
+  obj_string_t *key;
+  value_t value;
+} table_entry_t;
+
+/*
+  An open-addressing hash table from interned strings to values, backing
+  globals, instance fields, class methods and the intern set itself. It
+  probes linearly from the hash each obj_string_t caches, over a
+  power-of-two bucket array, so the probe is a mask rather than a modulo.
+  Since keys are interned, they compare by identity. count includes
+  tombstones, so a table full of deletions still rehashes instead of
+  running out of empty buckets; when tombstones are most of the load it
+  rehashes at the same capacity rather than growing.
+*/
+typedef struct table_t {
+  table_entry_t *entries;
+  size_t count;
+  size_t tombstones;
+  size_t capacity;
+  // Grow once count would exceed this percentage of capacity; below 100,
+  // so a probe always reaches an empty bucket.
+  int max_load;
+} table_t;
+
+void table_init(table_t *table);
+void table_free(table_t *table);
+// Returns 1 and stores the value in *value when key is present.
+int table_get(table_t *table, obj_string_t *key, value_t *value);
+// Returns 1 when key was not present before.
+int table_set(table_t *table, obj_string_t *key, value_t value);
+int table_delete(table_t *table, obj_string_t *key);
+void table_add_all(table_t *from, table_t *to);
+// Deletes every entry whose key the collector has not marked, making the
+// table a weak set of its keys.
+void table_remove_unmarked(table_t *table);
+// Looks a key up by content, for interning.
+obj_string_t *table_find_string(table_t *table, const char *chars,
+                                size_t length, uint32_t hash);
+
+#endif // TABLE_H
@@ -0,0 +1,169 @@
+#include "unrolled_list.h"
+#include <string.h>
+
+static unrolled_list_node_t *unrolled_list_node_new() {
+  unrolled_list_node_t *node =
+      aligned_alloc(UNROLLED_LIST_NODE_SIZE, sizeof(unrolled_list_node_t));
+  node->next = NULL;
+  node->prev = NULL;
+  node->count = 0;
+  return node;
+}
+
+static void unrolled_list_link_end(unrolled_list_t *list,
+                                   unrolled_list_node_t *node) {
+  node->prev = list->tail;
+  node->next = NULL;
+  if (list->tail != NULL) {
+    list->tail->next = node;
+  } else {
+    list->head = node;
+  }
+  list->tail = node;
+}
+
+static void unrolled_list_unlink(unrolled_list_t *list,
+                                 unrolled_list_node_t *node) {
+  if (node->prev != NULL) {
+    node->prev->next = node->next;
+  } else {
+    list->head = node->next;
+  }
+  if (node->next != NULL) {
+    node->next->prev = node->prev;
+  } else {
+    list->tail = node->prev;
+  }
+  free(node);
+}
+
+unrolled_list_t *unrolled_list_new() {
+  unrolled_list_t *list = malloc(sizeof(unrolled_list_t));
+  list->head = NULL;
+  list->tail = NULL;
+  list->size = 0;
+  return list;
+}
+
+void unrolled_list_free(unrolled_list_t *list) {
+  unrolled_list_node_t *node = list->head;
+  while (node != NULL) {
+    unrolled_list_node_t *next = node->next;
+    free(node);
+    node = next;
+  }
+  free(list);
+}
+
+void unrolled_list_insert_beginning(unrolled_list_t *list, void *data) {
+  unrolled_list_node_t *head = list->head;
+  if (head == NULL || head->count == UNROLLED_LIST_NODE_CAPACITY) {
+    head = unrolled_list_node_new();
+    head->next = list->head;
+    if (list->head != NULL) {
+      list->head->prev = head;
+    } else {
+      list->tail = head;
+    }
+    list->head = head;
+  }
+  memmove(&head->data[1], &head->data[0], head->count * sizeof(void *));
+  head->data[0] = data;
+  head->count++;
+  list->size++;
+}
+
+void unrolled_list_insert_end(unrolled_list_t *list, void *data) {
+  if (list->tail == NULL || list->tail->count == UNROLLED_LIST_NODE_CAPACITY) {
+    unrolled_list_link_end(list, unrolled_list_node_new());
+  }
+  list->tail->data[list->tail->count++] = data;
+  list->size++;
+}
+
+void unrolled_list_append(unrolled_list_t *list, void **data, size_t count) {
+  while (count > 0) {
+    if (list->tail == NULL ||
+        list->tail->count == UNROLLED_LIST_NODE_CAPACITY) {
+      unrolled_list_link_end(list, unrolled_list_node_new());
+    }
+    size_t room = UNROLLED_LIST_NODE_CAPACITY - list->tail->count;
+    size_t n = count < room ? count : room;
+    memcpy(&list->tail->data[list->tail->count], data, n * sizeof(void *));
+    list->tail->count += n;
+    list->size += n;
+    data += n;
+    count -= n;
+  }
+}
+
+// Moves every element of other to the end of list in O(1); other is left
+// empty.
+void unrolled_list_splice(unrolled_list_t *list, unrolled_list_t *other) {
+  if (other->head == NULL) {
+    return;
+  }
+  if (list->tail != NULL) {
+    list->tail->next = other->head;
+    other->head->prev = list->tail;
+  } else {
+    list->head = other->head;
+  }
+  list->tail = other->tail;
+  list->size += other->size;
+  other->head = NULL;
+  other->tail = NULL;
+  other->size = 0;
+}
+
+unrolled_list_iterator_t unrolled_list_begin(unrolled_list_t *list) {
+  return (unrolled_list_iterator_t){.node = list->head, .index = 0};
+}
+
+int unrolled_list_iterator_valid(unrolled_list_iterator_t iterator) {
+  return iterator.node != NULL;
+}
+
+void *unrolled_list_iterator_get(unrolled_list_iterator_t iterator) {
+  return iterator.node->data[iterator.index];
+}
+
+void unrolled_list_iterator_next(unrolled_list_iterator_t *iterator) {
+  if (++iterator->index == iterator->node->count) {
+    iterator->node = iterator->node->next;
+    iterator->index = 0;
+  }
+}
+
+/*
+  Removes the element under the iterator. A node that drops below a quarter
+  full absorbs its successor when both fit in one node, so long runs of
+  removals do not leave the list full of nearly empty nodes.
+*/
+void unrolled_list_remove(unrolled_list_t *list,
+                          unrolled_list_iterator_t *iterator) {
+  unrolled_list_node_t *node = iterator->node;
+  size_t index = iterator->index;
+  memmove(&node->data[index], &node->data[index + 1],
+          (node->count - index - 1) * sizeof(void *));
+  node->count--;
+  list->size--;
+
+  unrolled_list_node_t *next = node->next;
+  if (node->count == 0) {
+    unrolled_list_unlink(list, node);
+    iterator->node = next;
+    iterator->index = 0;
+    return;
+  }
+  if (node->count < UNROLLED_LIST_NODE_CAPACITY / 4 && next != NULL &&
+      node->count + next->count <= UNROLLED_LIST_NODE_CAPACITY) {
+    memcpy(&node->data[node->count], next->data, next->count * sizeof(void *));
+    node->count += next->count;
+    unrolled_list_unlink(list, next);
+  }
+  if (index == node->count) {
+    iterator->node = node->next;
+    iterator->index = 0;
+  }
+}
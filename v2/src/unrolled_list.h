@@ -0,0 +1,49 @@
+#ifndef UNROLLED_LIST_H
+#define UNROLLED_LIST_H
+
+#include <stdlib.h>
+
+#define UNROLLED_LIST_NODE_SIZE 128
+#define UNROLLED_LIST_NODE_CAPACITY                                            \
+  ((UNROLLED_LIST_NODE_SIZE - 3 * sizeof(void *)) / sizeof(void *))
+
+/*
+  A doubly linked list whose nodes each hold up to
+  UNROLLED_LIST_NODE_CAPACITY elements, so traversal touches one node (two
+  cache lines) per dozen elements instead of one node per element. Nodes may
+  be partly full anywhere in the list, which is what makes splice O(1).
+*/
+typedef struct unrolled_list_node_t {
+  struct unrolled_list_node_t *next;
+  struct unrolled_list_node_t *prev;
+  size_t count;
+  void *data[UNROLLED_LIST_NODE_CAPACITY];
+} unrolled_list_node_t;
+
+typedef struct unrolled_list_t {
+  unrolled_list_node_t *head;
+  unrolled_list_node_t *tail;
+  size_t size;
+} unrolled_list_t;
+
+// Position of one element; remove leaves it on the following element.
+typedef struct unrolled_list_iterator_t {
+  unrolled_list_node_t *node;
+  size_t index;
+} unrolled_list_iterator_t;
+
+unrolled_list_t *unrolled_list_new();
+void unrolled_list_free(unrolled_list_t *list);
+void unrolled_list_insert_beginning(unrolled_list_t *list, void *data);
+void unrolled_list_insert_end(unrolled_list_t *list, void *data);
+void unrolled_list_append(unrolled_list_t *list, void **data, size_t count);
+void unrolled_list_splice(unrolled_list_t *list, unrolled_list_t *other);
+
+unrolled_list_iterator_t unrolled_list_begin(unrolled_list_t *list);
+int unrolled_list_iterator_valid(unrolled_list_iterator_t iterator);
+void *unrolled_list_iterator_get(unrolled_list_iterator_t iterator);
+void unrolled_list_iterator_next(unrolled_list_iterator_t *iterator);
+void unrolled_list_remove(unrolled_list_t *list,
+                          unrolled_list_iterator_t *iterator);
+
+#endif // UNROLLED_LIST_H
@@ -0,0 +1,57 @@
+#include "value.h"
+#include "object.h"
+#include <stdlib.h>
+
+int value_equals(value_t a, value_t b) {
+  // Numbers compare as doubles, so NaN is unequal to itself. Strings are
+  // interned, so identity is equality for every object.
+  if (value_is_number(a) && value_is_number(b)) {
+    return value_as_number(a) == value_as_number(b);
+  }
+#ifndef VALUE_TAGGED_UNION
+  return a == b;
+#else
+  if (a.type != b.type) {
+    return 0;
+  }
+  switch (a.type) {
+  case VALUE_BOOL:
+    return value_as_bool(a) == value_as_bool(b);
+  case VALUE_OBJ:
+    return value_as_obj(a) == value_as_obj(b);
+  default:
+    return 1;
+  }
+#endif
+}
+
+void value_print(FILE *out, value_t value) {
+  if (value_is_nil(value)) {
+    fprintf(out, "nil");
+  } else if (value_is_bool(value)) {
+    fprintf(out, value_as_bool(value) ? "true" : "false");
+  } else if (value_is_number(value)) {
+    fprintf(out, "%g", value_as_number(value));
+  } else {
+    object_print(out, value);
+  }
+}
+
+void value_array_init(value_array_t *array) {
+  array->values = NULL;
+  array->count = 0;
+  array->capacity = 0;
+}
+
+void value_array_write(value_array_t *array, value_t value) {
+  if (array->count == array->capacity) {
+    array->capacity = array->capacity < 8 ? 8 : array->capacity * 2;
+    array->values = realloc(array->values, array->capacity * sizeof(value_t));
+  }
+  array->values[array->count++] = value;
+}
+
+void value_array_free(value_array_t *array) {
+  free(array->values);
+  value_array_init(array);
+}
@@ -0,0 +1,167 @@
+#ifndef VALUE_H
+#define VALUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef struct obj_t obj_t;
+typedef struct obj_string_t obj_string_t;
+
+#ifndef VALUE_TAGGED_UNION
+
+/*
+  NaN boxing: every value is one 64-bit word. Numbers are stored as their
+  IEEE 754 bits. Everything else hides in quiet NaN bit patterns that
+  arithmetic never produces: nil, false and true are the small tags 1-3,
+  and an object is its pointer (x86-64 and AArch64 use at most 48 bits)
+  with the sign bit also set. Build with -DVALUE_TAGGED_UNION for a struct that
+  debuggers can display.
+*/
+typedef uint64_t value_t;
+
+#define VALUE_SIGN_BIT ((uint64_t)0x8000000000000000)
+#define VALUE_QNAN ((uint64_t)0x7ffc000000000000)
+#define VALUE_TAG_NIL 1
+#define VALUE_TAG_FALSE 2
+#define VALUE_TAG_TRUE 3
+
+#define VALUE_NIL_BITS (VALUE_QNAN | VALUE_TAG_NIL)
+#define VALUE_FALSE_BITS (VALUE_QNAN | VALUE_TAG_FALSE)
+#define VALUE_TRUE_BITS (VALUE_QNAN | VALUE_TAG_TRUE)
+
+static inline value_t value_nil(void) { return VALUE_NIL_BITS; }
+
+static inline value_t value_bool(int boolean) {
+  return boolean ? VALUE_TRUE_BITS : VALUE_FALSE_BITS;
+}
+
+static inline value_t value_number(double number) {
+  value_t value;
+  memcpy(&value, &number, sizeof value);
+  return value;
+}
+
+static inline value_t value_obj(void *obj) {
+  return VALUE_SIGN_BIT | VALUE_QNAN | (uint64_t)(uintptr_t)obj;
+}
+
+static inline int value_is_nil(value_t value) {
+  return value == VALUE_NIL_BITS;
+}
+
+static inline int value_is_bool(value_t value) {
+  // false and true differ only in the low bit.
+  return (value | 1) == VALUE_TRUE_BITS;
+}
+
+static inline int value_is_number(value_t value) {
+  return (value & VALUE_QNAN) != VALUE_QNAN;
+}
+
+static inline int value_is_obj(value_t value) {
+  return (value & (VALUE_QNAN | VALUE_SIGN_BIT)) ==
+         (VALUE_QNAN | VALUE_SIGN_BIT);
+}
+
+static inline int value_as_bool(value_t value) {
+  return value == VALUE_TRUE_BITS;
+}
+
+static inline double value_as_number(value_t value) {
+  double number;
+  memcpy(&number, &value, sizeof number);
+  return number;
+}
+
+static inline obj_t *value_as_obj(value_t value) {
+  return (obj_t *)(uintptr_t)(value & ~(VALUE_SIGN_BIT | VALUE_QNAN));
+}
+
+// nil and false are falsey; every other value is truthy.
+static inline int value_is_falsey(value_t value) {
+  return value == VALUE_NIL_BITS || value == VALUE_FALSE_BITS;
+}
+
+#else
+
+// The debugging layout: a tag beside a union, 16 bytes per value.
+typedef enum value_type_t {
+  VALUE_NIL,
+  VALUE_BOOL,
+  VALUE_NUMBER,
+  VALUE_OBJ,
+} value_type_t;
+
+typedef struct value_t {
+  value_type_t type;
+  union {
+    int boolean;
+    double number;
+    obj_t *obj;
+  } as;
+} value_t;
+
+static inline value_t value_nil(void) {
+  return (value_t){.type = VALUE_NIL, .as.number = 0};
+}
+
+static inline value_t value_bool(int boolean) {
+  return (value_t){.type = VALUE_BOOL, .as.boolean = boolean != 0};
+}
+
+static inline value_t value_number(double number) {
+  return (value_t){.type = VALUE_NUMBER, .as.number = number};
+}
+
+static inline value_t value_obj(void *obj) {
+  return (value_t){.type = VALUE_OBJ, .as.obj = obj};
+}
+
+static inline int value_is_nil(value_t value) {
+  return value.type == VALUE_NIL;
+}
+
+static inline int value_is_bool(value_t value) {
+  return value.type == VALUE_BOOL;
+}
+
+static inline int value_is_number(value_t value) {
+  return value.type == VALUE_NUMBER;
+}
+
+static inline int value_is_obj(value_t value) {
+  return value.type == VALUE_OBJ;
+}
+
+static inline int value_as_bool(value_t value) { return value.as.boolean; }
+
+static inline double value_as_number(value_t value) {
+  return value.as.number;
+}
+
+static inline obj_t *value_as_obj(value_t value) { return value.as.obj; }
+
+// nil and false are falsey; every other value is truthy.
+static inline int value_is_falsey(value_t value) {
+  return value_is_nil(value) ||
+         (value_is_bool(value) && !value_as_bool(value));
+}
+
+#endif // VALUE_TAGGED_UNION
+
+int value_equals(value_t a, value_t b);
+void value_print(FILE *out, value_t value);
+
+typedef struct value_array_t {
+  value_t *values;
+  size_t count;
+  size_t capacity;
+} value_array_t;
+
+void value_array_init(value_array_t *array);
+void value_array_write(value_array_t *array, value_t value);
+void value_array_free(value_array_t *array);
+
+#endif // VALUE_H
@@ -0,0 +1,715 @@
+#include "vm.h"
+#include "compiler.h"
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+  With computed goto every handler ends in its own indirect jump through a
+  table of label addresses, instead of all of them sharing the switch's
+  one, which gives the branch predictor a history per opcode. Build with
+  -DVM_SWITCH_DISPATCH for the portable switch loop.
+*/
+#if defined(__GNUC__) && !defined(VM_SWITCH_DISPATCH)
+#define VM_COMPUTED_GOTO 1
+#endif
+
+static value_t clock_native(int arg_count, value_t *args) {
+  (void)arg_count;
+  (void)args;
+  return value_number((double)clock() / CLOCKS_PER_SEC);
+}
+
+static void reset_stack(vm_t *vm) {
+  vm->stack_top = vm->stack;
+  vm->frame_count = 0;
+  vm->open_upvalues = NULL;
+}
+
+static void runtime_error(vm_t *vm, const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  vfprintf(vm->err, format, args);
+  va_end(args);
+  fputs("\n", vm->err);
+
+  for (int i = vm->frame_count - 1; i >= 0; i--) {
+    call_frame_t *frame = &vm->frames[i];
+    obj_function_t *function = frame->closure->function;
+    // ip already points past the failing instruction.
+    size_t offset = (size_t)(frame->ip - function->chunk.code - 1);
+    fprintf(vm->err, "[line %d] in ", chunk_get_line(&function->chunk, offset));
+    if (function->name == NULL) {
+      fprintf(vm->err, "script\n");
+    } else {
+      fprintf(vm->err, "%s()\n", function->name->chars);
+    }
+  }
+  reset_stack(vm);
+}
+
+static void define_native(vm_t *vm, const char *name, native_fn_t function) {
+  // Both objects stay on the stack while the other is allocated.
+  vm_push(vm, value_obj(object_copy_string(vm, name, strlen(name))));
+  vm_push(vm, value_obj(object_new_native(vm, function)));
+  table_set(&vm->globals, value_as_string(vm->stack[0]), vm->stack[1]);
+  vm_pop(vm);
+  vm_pop(vm);
+}
+
+vm_t *vm_new() {
+  vm_t *vm = malloc(sizeof(vm_t));
+  reset_stack(vm);
+  vm->objects = doubly_linked_list_new();
+  gc_init(&vm->gc);
+  vm->compiler = NULL;
+  table_init(&vm->globals);
+  table_init(&vm->strings);
+  vm->out = stdout;
+  vm->err = stderr;
+  vm->init_string = NULL;
+  vm->init_string = object_copy_string(vm, "init", 4);
+  define_native(vm, "clock", clock_native);
+  return vm;
+}
+
+void vm_free(vm_t *vm) {
+  // Abandon any cycle in progress: everything is freed regardless.
+  vm->gc.phase = GC_IDLE;
+  table_free(&vm->globals);
+  table_free(&vm->strings);
+  doubly_linked_list_destroy(vm->objects, ^(doubly_linked_node_t *node) {
+    object_free(vm, doubly_linked_list_container_of(node, obj_t, link));
+  });
+  gc_free(&vm->gc);
+  free(vm);
+}
+
+void vm_push(vm_t *vm, value_t value) {
+  *vm->stack_top = value;
+  vm->stack_top++;
+}
+
+value_t vm_pop(vm_t *vm) {
+  vm->stack_top--;
+  return *vm->stack_top;
+}
+
+static value_t peek(vm_t *vm, int distance) {
+  return vm->stack_top[-1 - distance];
+}
+
+static int call(vm_t *vm, obj_closure_t *closure, int arg_count) {
+  if (arg_count != closure->function->arity) {
+    runtime_error(vm, "Expected %d arguments but got %d.",
+                  closure->function->arity, arg_count);
+    return 0;
+  }
+  if (vm->frame_count == VM_FRAMES_MAX) {
+    runtime_error(vm, "Stack overflow.");
+    return 0;
+  }
+  call_frame_t *frame = &vm->frames[vm->frame_count++];
+  frame->closure = closure;
+  frame->ip = closure->function->chunk.code;
+  frame->slots = vm->stack_top - arg_count - 1;
+  return 1;
+}
+
+static int call_value(vm_t *vm, value_t callee, int arg_count) {
+  if (value_is_obj(callee)) {
+    switch (value_as_obj(callee)->type) {
+    case OBJ_BOUND_METHOD: {
+      obj_bound_method_t *bound = (obj_bound_method_t *)value_as_obj(callee);
+      vm->stack_top[-arg_count - 1] = bound->receiver;
+      return call(vm, bound->method, arg_count);
+    }
+    case OBJ_CLASS: {
+      obj_class_t *klass = (obj_class_t *)value_as_obj(callee);
+      vm->stack_top[-arg_count - 1] =
+          value_obj(object_new_instance(vm, klass));
+      value_t initializer;
+      if (table_get(&klass->methods, vm->init_string, &initializer)) {
+        return call(vm, (obj_closure_t *)value_as_obj(initializer), arg_count);
+      }
+      if (arg_count != 0) {
+        runtime_error(vm, "Expected 0 arguments but got %d.", arg_count);
+        return 0;
+      }
+      return 1;
+    }
+    case OBJ_CLOSURE:
+      return call(vm, (obj_closure_t *)value_as_obj(callee), arg_count);
+    case OBJ_NATIVE: {
+      native_fn_t native = ((obj_native_t *)value_as_obj(callee))->function;
+      value_t result = native(arg_count, vm->stack_top - arg_count);
+      vm->stack_top -= arg_count + 1;
+      vm_push(vm, result);
+      return 1;
+    }
+    default:
+      break;
+    }
+  }
+  runtime_error(vm, "Can only call functions and classes.");
+  return 0;
+}
+
+static int invoke_from_class(vm_t *vm, obj_class_t *klass, obj_string_t *name,
+                             int arg_count) {
+  value_t method;
+  if (!table_get(&klass->methods, name, &method)) {
+    runtime_error(vm, "Undefined property '%s'.", name->chars);
+    return 0;
+  }
+  return call(vm, (obj_closure_t *)value_as_obj(method), arg_count);
+}
+
+static int invoke(vm_t *vm, obj_string_t *name, int arg_count) {
+  value_t receiver = peek(vm, arg_count);
+  if (!object_is(receiver, OBJ_INSTANCE)) {
+    runtime_error(vm, "Only instances have methods.");
+    return 0;
+  }
+  obj_instance_t *instance = (obj_instance_t *)value_as_obj(receiver);
+
+  // A field holding a function shadows a method of the same name.
+  value_t value;
+  if (table_get(&instance->fields, name, &value)) {
+    vm->stack_top[-arg_count - 1] = value;
+    return call_value(vm, value, arg_count);
+  }
+  return invoke_from_class(vm, instance->klass, name, arg_count);
+}
+
+static int bind_method(vm_t *vm, obj_class_t *klass, obj_string_t *name) {
+  value_t method;
+  if (!table_get(&klass->methods, name, &method)) {
+    runtime_error(vm, "Undefined property '%s'.", name->chars);
+    return 0;
+  }
+  obj_bound_method_t *bound = object_new_bound_method(
+      vm, peek(vm, 0), (obj_closure_t *)value_as_obj(method));
+  vm_pop(vm);
+  vm_push(vm, value_obj(bound));
+  return 1;
+}
+
+static obj_upvalue_t *capture_upvalue(vm_t *vm, value_t *local) {
+  obj_upvalue_t *previous = NULL;
+  obj_upvalue_t *upvalue = vm->open_upvalues;
+  while (upvalue != NULL && upvalue->location > local) {
+    previous = upvalue;
+    upvalue = upvalue->next;
+  }
+  if (upvalue != NULL && upvalue->location == local) {
+    return upvalue;
+  }
+
+  obj_upvalue_t *created = object_new_upvalue(vm, local);
+  created->next = upvalue;
+  if (previous == NULL) {
+    vm->open_upvalues = created;
+  } else {
+    previous->next = created;
+  }
+  return created;
+}
+
+// Closes every open upvalue at or above last.
+static void close_upvalues(vm_t *vm, value_t *last) {
+  while (vm->open_upvalues != NULL && vm->open_upvalues->location >= last) {
+    obj_upvalue_t *upvalue = vm->open_upvalues;
+    gc_write_barrier(vm, &upvalue->obj, *upvalue->location);
+    upvalue->closed = *upvalue->location;
+    upvalue->location = &upvalue->closed;
+    vm->open_upvalues = upvalue->next;
+  }
+}
+
+static void define_method(vm_t *vm, obj_string_t *name) {
+  value_t method = peek(vm, 0);
+  obj_class_t *klass = (obj_class_t *)value_as_obj(peek(vm, 1));
+  gc_write_barrier(vm, &klass->obj, value_obj(name));
+  gc_write_barrier(vm, &klass->obj, method);
+  table_set(&klass->methods, name, method);
+  vm_pop(vm);
+}
+
+static void concatenate(vm_t *vm) {
+  obj_string_t *b = value_as_string(peek(vm, 0));
+  obj_string_t *a = value_as_string(peek(vm, 1));
+  obj_string_t *result = object_concat_strings(vm, a, b);
+  vm_pop(vm);
+  vm_pop(vm);
+  vm_push(vm, value_obj(result));
+}
+
+// ADD's operands are not both numbers: concatenate two strings or fail.
+static int add_objects(vm_t *vm) {
+  if (object_is(peek(vm, 0), OBJ_STRING) &&
+      object_is(peek(vm, 1), OBJ_STRING)) {
+    concatenate(vm);
+    return 1;
+  }
+  runtime_error(vm, "Operands must be two numbers or two strings.");
+  return 0;
+}
+
+static interpret_result_t run(vm_t *vm) {
+  call_frame_t *frame = &vm->frames[vm->frame_count - 1];
+  // Cached in a local so the compiler can keep it in a register; written
+  // back to the frame before anything that might read it.
+  uint8_t *ip = frame->ip;
+
+#define READ_BYTE() (*ip++)
+#define READ_SHORT() (ip += 2, (uint16_t)((ip[-2] << 8) | ip[-1]))
+#define READ_CONSTANT()                                                        \
+  (frame->closure->function->chunk.constants.values[READ_SHORT()])
+#define READ_STRING() value_as_string(READ_CONSTANT())
+#define SAVE_FRAME() (frame->ip = ip)
+#define LOAD_FRAME()                                                           \
+  do {                                                                         \
+    frame = &vm->frames[vm->frame_count - 1];                                  \
+    ip = frame->ip;                                                            \
+  } while (0)
+#define BINARY_OP(value_type, op)                                              \
+  do {                                                                         \
+    if (!value_is_number(peek(vm, 0)) || !value_is_number(peek(vm, 1))) {      \
+      SAVE_FRAME();                                                            \
+      runtime_error(vm, "Operands must be numbers.");                          \
+      return INTERPRET_RUNTIME_ERROR;                                          \
+    }                                                                          \
+    double b = value_as_number(vm_pop(vm));                                    \
+    double a = value_as_number(vm_pop(vm));                                    \
+    vm_push(vm, value_type(a op b));                                           \
+  } while (0)
+// Pops two numbers and jumps when comparing them with op gives taken.
+#define COMPARE_JUMP(op, taken)                                                \
+  do {                                                                         \
+    uint16_t offset = READ_SHORT();                                            \
+    if (!value_is_number(peek(vm, 0)) || !value_is_number(peek(vm, 1))) {      \
+      SAVE_FRAME();                                                            \
+      runtime_error(vm, "Operands must be numbers.");                          \
+      return INTERPRET_RUNTIME_ERROR;                                          \
+    }                                                                          \
+    double b = value_as_number(vm_pop(vm));                                    \
+    double a = value_as_number(vm_pop(vm));                                    \
+    if ((a op b) == taken) {                                                   \
+      ip += offset;                                                            \
+    }                                                                          \
+  } while (0)
+
+#ifdef VM_COMPUTED_GOTO
+  static void *dispatch_table[] = {
+      [OP_CONSTANT] = &&OP_CONSTANT,
+      [OP_NIL] = &&OP_NIL,
+      [OP_TRUE] = &&OP_TRUE,
+      [OP_FALSE] = &&OP_FALSE,
+      [OP_POP] = &&OP_POP,
+      [OP_GET_LOCAL] = &&OP_GET_LOCAL,
+      [OP_SET_LOCAL] = &&OP_SET_LOCAL,
+      [OP_GET_GLOBAL] = &&OP_GET_GLOBAL,
+      [OP_DEFINE_GLOBAL] = &&OP_DEFINE_GLOBAL,
+      [OP_SET_GLOBAL] = &&OP_SET_GLOBAL,
+      [OP_GET_UPVALUE] = &&OP_GET_UPVALUE,
+      [OP_SET_UPVALUE] = &&OP_SET_UPVALUE,
+      [OP_GET_PROPERTY] = &&OP_GET_PROPERTY,
+      [OP_SET_PROPERTY] = &&OP_SET_PROPERTY,
+      [OP_GET_SUPER] = &&OP_GET_SUPER,
+      [OP_EQUAL] = &&OP_EQUAL,
+      [OP_GREATER] = &&OP_GREATER,
+      [OP_LESS] = &&OP_LESS,
+      [OP_ADD] = &&OP_ADD,
+      [OP_SUBTRACT] = &&OP_SUBTRACT,
+      [OP_MULTIPLY] = &&OP_MULTIPLY,
+      [OP_DIVIDE] = &&OP_DIVIDE,
+      [OP_NOT] = &&OP_NOT,
+      [OP_NEGATE] = &&OP_NEGATE,
+      [OP_PRINT] = &&OP_PRINT,
+      [OP_JUMP] = &&OP_JUMP,
+      [OP_JUMP_IF_FALSE] = &&OP_JUMP_IF_FALSE,
+      [OP_LOOP] = &&OP_LOOP,
+      [OP_CALL] = &&OP_CALL,
+      [OP_INVOKE] = &&OP_INVOKE,
+      [OP_SUPER_INVOKE] = &&OP_SUPER_INVOKE,
+      [OP_CLOSURE] = &&OP_CLOSURE,
+      [OP_CLOSE_UPVALUE] = &&OP_CLOSE_UPVALUE,
+      [OP_RETURN] = &&OP_RETURN,
+      [OP_CLASS] = &&OP_CLASS,
+      [OP_INHERIT] = &&OP_INHERIT,
+      [OP_METHOD] = &&OP_METHOD,
+      [OP_ADD_LOCALS] = &&OP_ADD_LOCALS,
+      [OP_ADD_CONSTANT] = &&OP_ADD_CONSTANT,
+      [OP_JUMP_IF_NOT_EQUAL] = &&OP_JUMP_IF_NOT_EQUAL,
+      [OP_JUMP_IF_NOT_GREATER] = &&OP_JUMP_IF_NOT_GREATER,
+      [OP_JUMP_IF_NOT_LESS] = &&OP_JUMP_IF_NOT_LESS,
+      [OP_JUMP_IF_EQUAL] = &&OP_JUMP_IF_EQUAL,
+      [OP_JUMP_IF_GREATER] = &&OP_JUMP_IF_GREATER,
+      [OP_JUMP_IF_LESS] = &&OP_JUMP_IF_LESS,
+  };
+  _Static_assert(sizeof dispatch_table / sizeof dispatch_table[0] ==
+                    OP_JUMP_IF_LESS + 1,
+                "every opcode needs a handler");
+  // Labels live in their own namespace, so each handler is simply named
+  // after its opcode.
+#define CASE(op) op
+#define DISPATCH() goto *dispatch_table[READ_BYTE()]
+  DISPATCH();
+  {
+#else
+#define CASE(op) case op
+#define DISPATCH() continue
+  for (;;) {
+    switch (READ_BYTE()) {
+#endif
+    CASE(OP_CONSTANT):
+      vm_push(vm, READ_CONSTANT());
+      DISPATCH();
+    CASE(OP_NIL):
+      vm_push(vm, value_nil());
+      DISPATCH();
+    CASE(OP_TRUE):
+      vm_push(vm, value_bool(1));
+      DISPATCH();
+    CASE(OP_FALSE):
+      vm_push(vm, value_bool(0));
+      DISPATCH();
+    CASE(OP_POP):
+      vm_pop(vm);
+      DISPATCH();
+    CASE(OP_GET_LOCAL): {
+      uint8_t slot = READ_BYTE();
+      vm_push(vm, frame->slots[slot]);
+      DISPATCH();
+    }
+    CASE(OP_SET_LOCAL): {
+      uint8_t slot = READ_BYTE();
+      frame->slots[slot] = peek(vm, 0);
+      DISPATCH();
+    }
+    CASE(OP_GET_GLOBAL): {
+      obj_string_t *name = READ_STRING();
+      value_t value;
+      if (!table_get(&vm->globals, name, &value)) {
+        SAVE_FRAME();
+        runtime_error(vm, "Undefined variable '%s'.", name->chars);
+        return INTERPRET_RUNTIME_ERROR;
+      }
+      vm_push(vm, value);
+      DISPATCH();
+    }
+    CASE(OP_DEFINE_GLOBAL): {
+      obj_string_t *name = READ_STRING();
+      table_set(&vm->globals, name, peek(vm, 0));
+      vm_pop(vm);
+      DISPATCH();
+    }
+    CASE(OP_SET_GLOBAL): {
+      obj_string_t *name = READ_STRING();
+      if (table_set(&vm->globals, name, peek(vm, 0))) {
+        // Assignment never implicitly declares a global.
+        table_delete(&vm->globals, name);
+        SAVE_FRAME();
+        runtime_error(vm, "Undefined variable '%s'.", name->chars);
+        return INTERPRET_RUNTIME_ERROR;
+      }
+      DISPATCH();
+    }
+    CASE(OP_GET_UPVALUE): {
+      uint8_t slot = READ_BYTE();
+      vm_push(vm, *frame->closure->upvalues[slot]->location);
+      DISPATCH();
+    }
+    CASE(OP_SET_UPVALUE): {
+      obj_upvalue_t *upvalue = frame->closure->upvalues[READ_BYTE()];
+      gc_write_barrier(vm, &upvalue->obj, peek(vm, 0));
+      *upvalue->location = peek(vm, 0);
+      DISPATCH();
+    }
+    CASE(OP_GET_PROPERTY): {
+      if (!object_is(peek(vm, 0), OBJ_INSTANCE)) {
+        SAVE_FRAME();
+        runtime_error(vm, "Only instances have properties.");
+        return INTERPRET_RUNTIME_ERROR;
+      }
+      obj_instance_t *instance = (obj_instance_t *)value_as_obj(peek(vm, 0));
+      obj_string_t *name = READ_STRING();
+      value_t value;
+      if (table_get(&instance->fields, name, &value)) {
+        vm_pop(vm);
+        vm_push(vm, value);
+        DISPATCH();
+      }
+      SAVE_FRAME();
+      if (!bind_method(vm, instance->klass, name)) {
+        return INTERPRET_RUNTIME_ERROR;
+      }
+      DISPATCH();
+    }
+    CASE(OP_SET_PROPERTY): {
+      if (!object_is(peek(vm, 1), OBJ_INSTANCE)) {
+        SAVE_FRAME();
+        runtime_error(vm, "Only instances have fields.");
+        return INTERPRET_RUNTIME_ERROR;
+      }
+      obj_instance_t *instance = (obj_instance_t *)value_as_obj(peek(vm, 1));
+      obj_string_t *name = READ_STRING();
+      gc_write_barrier(vm, &instance->obj, value_obj(name));
+      gc_write_barrier(vm, &instance->obj, peek(vm, 0));
+      table_set(&instance->fields, name, peek(vm, 0));
+      value_t value = vm_pop(vm);
+      vm_pop(vm);
+      vm_push(vm, value);
+      DISPATCH();
+    }
+    CASE(OP_GET_SUPER): {
+      obj_string_t *name = READ_STRING();
+      obj_class_t *superclass = (obj_class_t *)value_as_obj(vm_pop(vm));
+      SAVE_FRAME();
+      if (!bind_method(vm, superclass, name)) {
+        return INTERPRET_RUNTIME_ERROR;
+      }
+      DISPATCH();
+    }
+    CASE(OP_EQUAL): {
+      value_t b = vm_pop(vm);
+      value_t a = vm_pop(vm);
+      vm_push(vm, value_bool(value_equals(a, b)));
+      DISPATCH();
+    }
+    CASE(OP_GREATER):
+      BINARY_OP(value_bool, >);
+      DISPATCH();
+    CASE(OP_LESS):
+      BINARY_OP(value_bool, <);
+      DISPATCH();
+    CASE(OP_ADD): {
+      if (value_is_number(peek(vm, 0)) && value_is_number(peek(vm, 1))) {
+        double b = value_as_number(vm_pop(vm));
+        double a = value_as_number(vm_pop(vm));
+        vm_push(vm, value_number(a + b));
+        DISPATCH();
+      }
+      SAVE_FRAME();
+      if (!add_objects(vm)) {
+        return INTERPRET_RUNTIME_ERROR;
+      }
+      DISPATCH();
+    }
+    CASE(OP_SUBTRACT):
+      BINARY_OP(value_number, -);
+      DISPATCH();
+    CASE(OP_MULTIPLY):
+      BINARY_OP(value_number, *);
+      DISPATCH();
+    CASE(OP_DIVIDE):
+      BINARY_OP(value_number, /);
+      DISPATCH();
+    CASE(OP_NOT):
+      vm_push(vm, value_bool(value_is_falsey(vm_pop(vm))));
+      DISPATCH();
+    CASE(OP_NEGATE):
+      if (!value_is_number(peek(vm, 0))) {
+        SAVE_FRAME();
+        runtime_error(vm, "Operand must be a number.");
+        return INTERPRET_RUNTIME_ERROR;
+      }
+      vm_push(vm, value_number(-value_as_number(vm_pop(vm))));
+      DISPATCH();
+    CASE(OP_PRINT):
+      value_print(vm->out, vm_pop(vm));
+      fputc('\n', vm->out);
+      DISPATCH();
+    CASE(OP_JUMP): {
+      uint16_t offset = READ_SHORT();
+      ip += offset;
+      DISPATCH();
+    }
+    CASE(OP_JUMP_IF_FALSE): {
+      uint16_t offset = READ_SHORT();
+      if (value_is_falsey(peek(vm, 0))) {
+        ip += offset;
+      }
+      DISPATCH();
+    }
+    CASE(OP_LOOP): {
+      uint16_t offset = READ_SHORT();
+      ip -= offset;
+      DISPATCH();
+    }
+    CASE(OP_CALL): {
+      int arg_count = READ_BYTE();
+      SAVE_FRAME();
+      if (!call_value(vm, peek(vm, arg_count), arg_count)) {
+        return INTERPRET_RUNTIME_ERROR;
+      }
+      LOAD_FRAME();
+      DISPATCH();
+    }
+    CASE(OP_INVOKE): {
+      obj_string_t *method = READ_STRING();
+      int arg_count = READ_BYTE();
+      SAVE_FRAME();
+      if (!invoke(vm, method, arg_count)) {
+        return INTERPRET_RUNTIME_ERROR;
+      }
+      LOAD_FRAME();
+      DISPATCH();
+    }
+    CASE(OP_SUPER_INVOKE): {
+      obj_string_t *method = READ_STRING();
+      int arg_count = READ_BYTE();
+      obj_class_t *superclass = (obj_class_t *)value_as_obj(vm_pop(vm));
+      SAVE_FRAME();
+      if (!invoke_from_class(vm, superclass, method, arg_count)) {
+        return INTERPRET_RUNTIME_ERROR;
+      }
+      LOAD_FRAME();
+      DISPATCH();
+    }
+    CASE(OP_CLOSURE): {
+      obj_function_t *function =
+          (obj_function_t *)value_as_obj(READ_CONSTANT());
+      obj_closure_t *closure = object_new_closure(vm, function);
+      vm_push(vm, value_obj(closure));
+      for (int i = 0; i < closure->upvalue_count; i++) {
+        uint8_t is_local = READ_BYTE();
+        uint8_t index = READ_BYTE();
+        if (is_local) {
+          closure->upvalues[i] = capture_upvalue(vm, frame->slots + index);
+        } else {
+          closure->upvalues[i] = frame->closure->upvalues[index];
+        }
+        gc_write_barrier(vm, &closure->obj, value_obj(closure->upvalues[i]));
+      }
+      DISPATCH();
+    }
+    CASE(OP_CLOSE_UPVALUE):
+      close_upvalues(vm, vm->stack_top - 1);
+      vm_pop(vm);
+      DISPATCH();
+    CASE(OP_RETURN): {
+      value_t result = vm_pop(vm);
+      close_upvalues(vm, frame->slots);
+      vm->frame_count--;
+      if (vm->frame_count == 0) {
+        vm_pop(vm);
+        return INTERPRET_OK;
+      }
+      vm->stack_top = frame->slots;
+      vm_push(vm, result);
+      LOAD_FRAME();
+      DISPATCH();
+    }
+    CASE(OP_CLASS):
+      vm_push(vm, value_obj(object_new_class(vm, READ_STRING())));
+      DISPATCH();
+    CASE(OP_INHERIT): {
+      value_t superclass = peek(vm, 1);
+      if (!object_is(superclass, OBJ_CLASS)) {
+        SAVE_FRAME();
+        runtime_error(vm, "Superclass must be a class.");
+        return INTERPRET_RUNTIME_ERROR;
+      }
+      obj_class_t *subclass = (obj_class_t *)value_as_obj(peek(vm, 0));
+      // Marking the superclass marks every method copied from it.
+      gc_write_barrier(vm, &subclass->obj, superclass);
+      // Copy-down inheritance: methods defined later override these.
+      table_add_all(&((obj_class_t *)value_as_obj(superclass))->methods,
+                  &subclass->methods);
+      vm_pop(vm);
+      DISPATCH();
+    }
+    CASE(OP_METHOD):
+      define_method(vm, READ_STRING());
+      DISPATCH();
+    CASE(OP_ADD_LOCALS): {
+      value_t a = frame->slots[READ_BYTE()];
+      value_t b = frame->slots[READ_BYTE()];
+      if (value_is_number(a) && value_is_number(b)) {
+        vm_push(vm, value_number(value_as_number(a) + value_as_number(b)));
+        DISPATCH();
+      }
+      vm_push(vm, a);
+      vm_push(vm, b);
+      SAVE_FRAME();
+      if (!add_objects(vm)) {
+        return INTERPRET_RUNTIME_ERROR;
+      }
+      DISPATCH();
+    }
+    CASE(OP_ADD_CONSTANT): {
+      value_t b = READ_CONSTANT();
+      if (value_is_number(peek(vm, 0)) && value_is_number(b)) {
+        vm->stack_top[-1] =
+            value_number(value_as_number(peek(vm, 0)) + value_as_number(b));
+        DISPATCH();
+      }
+      vm_push(vm, b);
+      SAVE_FRAME();
+      if (!add_objects(vm)) {
+        return INTERPRET_RUNTIME_ERROR;
+      }
+      DISPATCH();
+    }
+    CASE(OP_JUMP_IF_NOT_EQUAL): {
+      uint16_t offset = READ_SHORT();
+      value_t b = vm_pop(vm);
+      value_t a = vm_pop(vm);
+      if (!value_equals(a, b)) {
+        ip += offset;
+      }
+      DISPATCH();
+    }
+    CASE(OP_JUMP_IF_NOT_GREATER):
+      COMPARE_JUMP(>, 0);
+      DISPATCH();
+    CASE(OP_JUMP_IF_NOT_LESS):
+      COMPARE_JUMP(<, 0);
+      DISPATCH();
+    CASE(OP_JUMP_IF_EQUAL): {
+      uint16_t offset = READ_SHORT();
+      value_t b = vm_pop(vm);
+      value_t a = vm_pop(vm);
+      if (value_equals(a, b)) {
+        ip += offset;
+      }
+      DISPATCH();
+    }
+    CASE(OP_JUMP_IF_GREATER):
+      COMPARE_JUMP(>, 1);
+      DISPATCH();
+    CASE(OP_JUMP_IF_LESS):
+      COMPARE_JUMP(<, 1);
+      DISPATCH();
+#ifndef VM_COMPUTED_GOTO
+    }
+#endif
+  }
+
+#undef CASE
+#undef DISPATCH
+#undef READ_BYTE
+#undef READ_SHORT
+#undef READ_CONSTANT
+#undef READ_STRING
+#undef SAVE_FRAME
+#undef LOAD_FRAME
+#undef BINARY_OP
+#undef COMPARE_JUMP
+}
+
+interpret_result_t vm_interpret(vm_t *vm, scanner_t *scanner) {
+  obj_function_t *function = compiler_compile(vm, scanner);
+  if (function == NULL) {
+    return INTERPRET_COMPILE_ERROR;
+  }
+  vm_push(vm, value_obj(function));
+  obj_closure_t *closure = object_new_closure(vm, function);
+  vm_pop(vm);
+  vm_push(vm, value_obj(closure));
+  call(vm, closure, 0);
+  return run(vm);
+}
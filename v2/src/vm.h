@@ -0,0 +1,54 @@
+#ifndef VM_H
+#define VM_H
+
+#include "doubly_linked_list.h"
+#include "gc.h"
+#include "object.h"
+#include "scanner.h"
+#include "table.h"
+#include "value.h"
+
+#define VM_FRAMES_MAX 64
+#define VM_STACK_MAX (VM_FRAMES_MAX * 256)
+
+typedef struct call_frame_t {
+  obj_closure_t *closure;
+  uint8_t *ip;
+  // The callee's first stack slot: the closure itself (or this), then the
+  // arguments and locals.
+  value_t *slots;
+} call_frame_t;
+
+typedef enum interpret_result_t {
+  INTERPRET_OK,
+  INTERPRET_COMPILE_ERROR,
+  INTERPRET_RUNTIME_ERROR,
+} interpret_result_t;
+
+struct vm_t {
+  call_frame_t frames[VM_FRAMES_MAX];
+  int frame_count;
+  value_t stack[VM_STACK_MAX];
+  value_t *stack_top;
+  table_t globals;
+  table_t strings;
+  obj_string_t *init_string;
+  obj_upvalue_t *open_upvalues;
+  // Every heap object, threaded through obj_t.link.
+  doubly_linked_list_t *objects;
+  gc_t gc;
+  // The innermost function being compiled, or NULL outside compilation.
+  struct compiler_t *compiler;
+  // print writes to out; compile and runtime errors go to err.
+  FILE *out;
+  FILE *err;
+};
+
+vm_t *vm_new();
+void vm_free(vm_t *vm);
+// Compiles the tokens the scanner produces and runs them.
+interpret_result_t vm_interpret(vm_t *vm, scanner_t *scanner);
+void vm_push(vm_t *vm, value_t value);
+value_t vm_pop(vm_t *vm);
+
+#endif // VM_H
@@ -80,6 +80,122 @@ int main() {
                 "again");
 
     free(list);
+
+    doubly_linked_node_pool_t *pool = doubly_linked_node_pool_new(4);
+    doubly_linked_list_t *pooled_list = doubly_linked_list_new();
+
+    doubly_linked_node_t *pooled_nodes[6];
+    for (int i = 0; i < 6; i++) {
+      pooled_nodes[i] = doubly_linked_node_pool_alloc(pool);
+      doubly_linked_list_insert_end(pooled_list, pooled_nodes[i]);
+    }
+
+    t->ok("pool has 6 nodes allocated", pool->allocated == 6);
+    t->ok("pooled list has 6 elements", pooled_list->size == 6);
+    t->ok("pool nodes in a chunk are contiguous",
+          pooled_nodes[1] == pooled_nodes[0] + 1);
+    t->ok("pooled list tail is the last node",
+          pooled_list->tail == pooled_nodes[5]);
+
+    doubly_linked_list_remove(pooled_list, pooled_nodes[2]);
+    doubly_linked_node_pool_release(pool, pooled_nodes[2]);
+
+    t->ok("pool has 5 nodes allocated", pool->allocated == 5);
+    t->ok("released node is handed out again",
+          doubly_linked_node_pool_alloc(pool) == pooled_nodes[2]);
+
+    free(pooled_list);
+    doubly_linked_node_pool_free(pool);
+
+    typedef struct {
+      int value;
+      doubly_linked_node_t link;
+    } item_t;
+
+    item_t items[3] = {{.value = 1}, {.value = 2}, {.value = 3}};
+    doubly_linked_list_t *intrusive_list = doubly_linked_list_new();
+    for (int i = 0; i < 3; i++) {
+      doubly_linked_list_insert_end(intrusive_list, &items[i].link);
+    }
+
+    t->ok("intrusive list has 3 elements", intrusive_list->size == 3);
+    t->ok("intrusive head recovers the first item",
+          doubly_linked_list_container_of(intrusive_list->head, item_t, link)
+                  ->value == 1);
+    t->ok("intrusive tail recovers the last item",
+          doubly_linked_list_container_of(intrusive_list->tail, item_t, link)
+                  ->value == 3);
+
+    free(intrusive_list);
+
+    doubly_linked_node_t stale = {.next = &stale, .prev = &stale};
+    doubly_linked_list_t *queue = doubly_linked_list_new();
+    doubly_linked_list_insert_beginning(queue, &stale);
+
+    t->ok("insert beginning on an empty list resets next", stale.next == NULL);
+    t->ok("insert beginning on an empty list resets prev", stale.prev == NULL);
+
+    doubly_linked_node_t queued[6];
+    for (int i = 0; i < 6; i++) {
+      queued[i].data = &queued[i];
+      doubly_linked_list_insert_end(queue, &queued[i]);
+    }
+    doubly_linked_list_remove(queue, &queued[2]);
+
+    t->ok("removed node next is null", queued[2].next == NULL);
+    t->ok("removed node prev is null", queued[2].prev == NULL);
+
+    t->ok("pop front returns the head",
+          doubly_linked_list_pop_front(queue) == &stale);
+    t->ok("pop back returns the tail",
+          doubly_linked_list_pop_back(queue) == &queued[5]);
+    t->ok("queue has 4 elements", queue->size == 4);
+
+    doubly_linked_list_t *other = doubly_linked_list_new();
+    doubly_linked_list_insert_end(other, &queued[2]);
+    doubly_linked_list_insert_end(other, &queued[5]);
+    doubly_linked_list_splice(queue, &queued[1], other);
+
+    t->ok("splice adds the other list's size", queue->size == 6);
+    t->ok("splice empties the other list",
+          other->size == 0 && other->head == NULL && other->tail == NULL);
+    t->ok("splice links the first moved node",
+          queued[1].next == &queued[2] && queued[2].prev == &queued[1]);
+    t->ok("splice links the last moved node",
+          queued[5].next == &queued[3] && queued[3].prev == &queued[5]);
+
+    doubly_linked_list_insert_end(other, &stale);
+    doubly_linked_list_concat(queue, other);
+
+    t->ok("concat appends to the tail", queue->tail == &stale);
+    t->ok("concat links the old tail", queued[4].next == &stale);
+
+    doubly_linked_list_concat(other, queue);
+
+    t->ok("concat into an empty list moves the head",
+          other->head == &queued[0]);
+    t->ok("concat into an empty list moves the size", other->size == 7);
+
+    doubly_linked_node_t *node;
+    doubly_linked_node_t *next;
+    doubly_linked_list_for_each_safe(other, node, next) {
+      if (node != &queued[0] && node != &stale) {
+        doubly_linked_list_remove(other, node);
+      }
+    }
+
+    t->ok("safe iteration removes while walking", other->size == 2);
+    t->ok("safe iteration keeps the list linked",
+          other->head->next == other->tail && other->tail->prev == other->head);
+
+    __block int destroyed = 0;
+    doubly_linked_list_destroy(other, ^(doubly_linked_node_t *destroyed_node) {
+      destroyed += destroyed_node == &queued[0] || destroyed_node == &stale;
+    });
+
+    t->ok("destroy hands every node to the callback", destroyed == 2);
+
+    doubly_linked_list_destroy(queue, NULL);
   });
 
   exit(testStatus);
@@ -0,0 +1,237 @@
+#include <Block.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gc.h>
+#include <tape/tape.h>
+#include <vm.h>
+
+static interpret_result_t interpret(vm_t *vm, const char *source) {
+  scanner_t scanner;
+  scanner_init(&scanner, source, strlen(source));
+  return vm_interpret(vm, &scanner);
+}
+
+// Runs source on a vm that does collector work before every allocation
+// and checks it printed exactly expected, so any object the collector
+// fails to reach is freed while still in use. Stop-the-world mode collects
+// fully each time; incremental mode interleaves the smallest slices.
+static int stress_prints(gc_mode_t mode, const char *source,
+                         const char *expected) {
+  char *out;
+  size_t out_length;
+  vm_t *vm = vm_new();
+  vm->gc.mode = mode;
+  vm->gc.stress = 1;
+  vm->out = open_memstream(&out, &out_length);
+  interpret_result_t result = interpret(vm, source);
+  fclose(vm->out);
+  int ok = vm->gc.pauses.count > 0 && result == INTERPRET_OK &&
+           strcmp(out, expected) == 0;
+  if (!ok) {
+    fprintf(stderr, "got %d \"%s\"\n", result, out);
+  }
+  vm_free(vm);
+  free(out);
+  return ok;
+}
+
+static const struct {
+  const char *name;
+  const char *source;
+  const char *expected;
+} programs[] = {
+    {"strings",
+     "var a = \"he\"; var b = a + \"llo\";"
+     "for (var i = 0; i < 3; i = i + 1) b = b + \"!\";"
+     "print b;",
+     "hello!!!\n"},
+    {"closures and upvalues",
+     "fun counter() {"
+     "  var n = 0;"
+     "  fun next() { n = n + 1; return n; }"
+     "  return next;"
+     "}"
+     "var c = counter(); c(); c(); print c();",
+     "3\n"},
+    {"closed upvalues outlive their frame",
+     "var fs;"
+     "{ var s = \"kept\"; fun f() { return s; } fs = f; }"
+     "print fs();",
+     "kept\n"},
+    {"classes, fields and bound methods",
+     "class A {"
+     "  init(x) { this.x = x + \"!\"; }"
+     "  get() { return this.x; }"
+     "}"
+     "class B < A { get() { return super.get() + \"?\"; } }"
+     "var m = B(\"b\").get; print m();",
+     "b!?\n"},
+    {"nested function declarations",
+     "fun outer() {"
+     "  fun middle() { fun inner() { return \"in\"; }"
+     "    return inner; }"
+     "  return middle()();"
+     "}"
+     "print outer();",
+     "in\n"},
+    {"references moved between objects",
+     "class Box {}"
+     "var a = Box(); var b = Box();"
+     "a.v = \"x\" + \"1\";"
+     "for (var i = 0; i < 50; i = i + 1) {"
+     "  b.v = a.v; a.v = Box(); a.v = b.v + \"\";"
+     "  var up = \"u\" + \"p\";"
+     "  fun set() { up = b.v; }"
+     "  set(); b.v = nil; b.v = up;"
+     "}"
+     "print a.v + b.v;",
+     "x1x1\n"},
+};
+
+// Whether the vm's intern set holds a string equal to chars.
+static int interned(vm_t *vm, const char *chars) {
+  for (size_t i = 0; i < vm->strings.capacity; i++) {
+    obj_string_t *key = vm->strings.entries[i].key;
+    if (key != NULL && strcmp(key->chars, chars) == 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int main() {
+  tape_t *test = tape();
+
+  int testStatus = test->test("gc", ^(tape_t *t) {
+    t->clearState();
+
+    for (size_t i = 0; i < sizeof programs / sizeof programs[0]; i++) {
+      char name[128];
+      snprintf(name, sizeof name, "stress: %s", programs[i].name);
+      t->ok(name, stress_prints(GC_MODE_STOP_THE_WORLD, programs[i].source,
+                                programs[i].expected));
+      snprintf(name, sizeof name, "incremental stress: %s", programs[i].name);
+      t->ok(name, stress_prints(GC_MODE_INCREMENTAL, programs[i].source,
+                                programs[i].expected));
+    }
+
+    vm_t *vm = vm_new();
+    FILE *out = fopen("/dev/null", "w");
+    vm->out = out;
+
+    vm->gc.next_gc = 64 * 1024;
+    t->ok("a garbage loop runs",
+          interpret(vm, "for (var i = 0; i < 100000; i = i + 1) {"
+                        "  var s = \"x\" + \"y\";"
+                        "  fun f() { return i; }"
+                        "}") == INTERPRET_OK);
+    t->ok("the garbage loop triggered collections", vm->gc.collections > 0);
+    t->ok("the heap stays bounded under a garbage loop",
+          vm->gc.bytes_allocated < 2 * GC_INITIAL_THRESHOLD);
+
+    interpret(vm, "var s = \"un\" + \"reachable\"; s = nil;");
+    t->ok("concatenation interns its result", interned(vm, "unreachable"));
+    gc_collect(vm);
+    t->ok("unreachable interned strings are swept",
+          !interned(vm, "unreachable") && !interned(vm, "un"));
+
+    interpret(vm, "var kept = \"still\" + \"here\";");
+    gc_collect(vm);
+    t->ok("reachable interned strings survive", interned(vm, "stillhere"));
+
+    const char *cycle =
+        "{ var a = Node(); var b = Node(); a.next = b; b.next = a; }";
+    interpret(vm, "class Node {}");
+    interpret(vm, cycle);
+    gc_collect(vm);
+    size_t without_cycle = vm->gc.bytes_allocated;
+    interpret(vm, cycle);
+    gc_collect(vm);
+    t->ok("cycles are collected", vm->gc.bytes_allocated == without_cycle);
+
+    vm_free(vm);
+
+    char *log;
+    size_t log_length;
+    char *printed;
+    size_t printed_length;
+    vm = vm_new();
+    vm->out = open_memstream(&printed, &printed_length);
+    vm->gc.mode = GC_MODE_INCREMENTAL;
+    vm->gc.next_gc = 64 * 1024;
+    vm->gc.log = open_memstream(&log, &log_length);
+    t->ok("an incremental garbage loop runs",
+          interpret(vm, "class Node { init(next) { this.next = next; } }"
+                        "var live;"
+                        "for (var i = 0; i < 5000; i = i + 1) {"
+                        "  live = Node(live);"
+                        "}"
+                        "for (var i = 0; i < 100000; i = i + 1) {"
+                        "  var garbage = Node(nil);"
+                        "  live.next = Node(live.next.next);"
+                        "}"
+                        "var n = 0;"
+                        "while (live != nil) { n = n + 1; live = live.next; }"
+                        "print n;") == INTERPRET_OK);
+    fclose(vm->out);
+    t->ok("the incremental garbage loop keeps every live node",
+          strcmp(printed, "5000\n") == 0);
+    free(printed);
+    vm->out = out;
+    t->ok("incremental cycles finish", vm->gc.collections > 0);
+    t->ok("incremental cycles are split into several pauses",
+          vm->gc.pauses.count > vm->gc.collections);
+    t->ok("the heap stays bounded in incremental mode",
+          vm->gc.bytes_allocated < 4 * GC_INITIAL_THRESHOLD);
+    size_t bucketed = 0;
+    for (size_t i = 0; i < GC_PAUSE_BUCKETS; i++) {
+      bucketed += vm->gc.pauses.buckets[i];
+    }
+    t->ok("every pause lands in a histogram bucket",
+          bucketed == vm->gc.pauses.count);
+    t->ok("the longest pause is within the total",
+          vm->gc.pauses.max > 0 && vm->gc.pauses.max <= vm->gc.pauses.total);
+    fclose(vm->gc.log);
+    t->ok("each cycle logs its pause histogram",
+          strstr(log, " bytes, next at ") != NULL &&
+              strstr(log, " pauses, ") != NULL);
+    free(log);
+
+    vm->gc.log = NULL;
+    gc_collect(vm);
+    t->ok("a full collection finishes the cycle in progress",
+          vm->gc.phase == GC_IDLE);
+
+    // With a slice after every allocation, a cycle soon starts marking the
+    // live list; then memory allocated and released within the phase, like
+    // a concatenation whose result was already interned, must not count as
+    // marked.
+    vm->gc.stress = 1;
+    for (int i = 0; i < 1000 && vm->gc.phase != GC_MARKING; i++) {
+      gc_release(vm, gc_allocate(vm, 64), 64);
+    }
+    vm->gc.stress = 0;
+    vm->gc.debt = 0;
+    size_t marked = vm->gc.marked_bytes;
+    void *fresh = gc_allocate(vm, 64);
+    t->ok("allocating while marking counts as marked",
+          vm->gc.phase == GC_MARKING && vm->gc.marked_bytes == marked + 64);
+    gc_release(vm, fresh, 64);
+    t->ok("releasing while marking takes the count back",
+          vm->gc.marked_bytes == marked);
+    object_copy_string(vm, "5000", 4);
+    obj_string_t *head = object_copy_string(vm, "50", 2);
+    obj_string_t *tail = object_copy_string(vm, "00", 2);
+    marked = vm->gc.marked_bytes;
+    size_t allocated = vm->gc.bytes_allocated;
+    object_concat_strings(vm, head, tail);
+    t->ok("concatenating to an interned string while marking leaves no trace",
+          vm->gc.phase == GC_MARKING && vm->gc.marked_bytes == marked &&
+              vm->gc.bytes_allocated == allocated);
+    vm_free(vm);
+    fclose(out);
+  });
+
+  exit(testStatus);
+}
@@ -0,0 +1,86 @@
+#include <Block.h>
+#include <mpsc_queue.h>
+#include <tape/tape.h>
+
+#define PRODUCERS 8
+#define ITEMS_PER_PRODUCER 100000
+
+typedef struct {
+  int producer;
+  int sequence;
+  doubly_linked_node_t link;
+} work_item_t;
+
+typedef struct {
+  mpsc_queue_t *queue;
+  work_item_t *items;
+} producer_t;
+
+static void *produce(void *arg) {
+  producer_t *producer = arg;
+  for (int i = 0; i < ITEMS_PER_PRODUCER; i++) {
+    mpsc_queue_push(producer->queue, &producer->items[i].link);
+  }
+  return NULL;
+}
+
+int main() {
+  tape_t *test = tape();
+
+  int testStatus = test->test("mpsc queue", ^(tape_t *t) {
+    t->clearState();
+
+    mpsc_queue_t *queue = mpsc_queue_new();
+
+    t->ok("empty queue pops null", mpsc_queue_pop(queue) == NULL);
+
+    doubly_linked_node_t nodes[3];
+    for (int i = 0; i < 3; i++) {
+      mpsc_queue_push(queue, &nodes[i]);
+    }
+
+    t->ok("pops the first node", mpsc_queue_pop(queue) == &nodes[0]);
+    t->ok("pops the second node", mpsc_queue_pop(queue) == &nodes[1]);
+    t->ok("waits for the last node", mpsc_queue_wait(queue) == &nodes[2]);
+    t->ok("drained queue pops null", mpsc_queue_pop(queue) == NULL);
+
+    work_item_t *items =
+        malloc(sizeof(work_item_t) * PRODUCERS * ITEMS_PER_PRODUCER);
+    producer_t producers[PRODUCERS];
+    pthread_t threads[PRODUCERS];
+    for (int p = 0; p < PRODUCERS; p++) {
+      producers[p].queue = queue;
+      producers[p].items = &items[p * ITEMS_PER_PRODUCER];
+      for (int i = 0; i < ITEMS_PER_PRODUCER; i++) {
+        producers[p].items[i].producer = p;
+        producers[p].items[i].sequence = i;
+      }
+      pthread_create(&threads[p], NULL, produce, &producers[p]);
+    }
+
+    int expected[PRODUCERS] = {0};
+    int ordered = 1;
+    int received = 0;
+    for (; received < PRODUCERS * ITEMS_PER_PRODUCER; received++) {
+      work_item_t *item = doubly_linked_list_container_of(
+          mpsc_queue_wait(queue), work_item_t, link);
+      ordered &= item->sequence == expected[item->producer];
+      expected[item->producer] = item->sequence + 1;
+    }
+
+    for (int p = 0; p < PRODUCERS; p++) {
+      pthread_join(threads[p], NULL);
+    }
+
+    t->ok("receives every item from 8 producers",
+          received == PRODUCERS * ITEMS_PER_PRODUCER);
+    t->ok("keeps each producer's items in order", ordered);
+    t->ok("queue is empty after the producers finish",
+          mpsc_queue_pop(queue) == NULL);
+
+    free(items);
+    mpsc_queue_free(queue);
+  });
+
+  exit(testStatus);
+}
@@ -0,0 +1,138 @@
+#include <Block.h>
+#include <parallel_scanner.h>
+#include <stdint.h>
+#include <string.h>
+#include <tape/tape.h>
+
+static const char *fragments[] = {
+    "var answer = 42;\n",
+    "print \"a string\nspanning lines // not a comment\";\n",
+    "/* a block comment\n/* nested \"quote\n*/ still\ncommented */\n",
+    "// a line comment with a \"quote and /* opener\n",
+    "fun f(a, b) { return a / b * 2.5; }\n",
+    "x = \"/*\"; y = \"*/\";\n",
+    "/* \" */ z = 1;\n",
+    "if (a >= b and !c) {\n  print nil;\n}\n",
+    "@ # unexpected\n",
+    "\n\n\t  \r\n",
+    "a/b/c//d\n",
+    "/*/ still a comment */\n",
+};
+
+static uint64_t next(uint64_t *state) {
+  *state ^= *state << 13;
+  *state ^= *state >> 7;
+  *state ^= *state << 17;
+  return *state;
+}
+
+static char *generate(size_t target, const char *tail, size_t *length) {
+  char *source = malloc(target + 256);
+  uint64_t state = 0x9e3779b97f4a7c15;
+  size_t used = 0;
+  while (used < target) {
+    const char *fragment =
+        fragments[next(&state) % (sizeof fragments / sizeof fragments[0])];
+    memcpy(source + used, fragment, strlen(fragment));
+    used += strlen(fragment);
+  }
+  memcpy(source + used, tail, strlen(tail));
+  *length = used + strlen(tail);
+  return source;
+}
+
+// Repeats line until the source reaches target bytes.
+static char *repeat(const char *line, size_t target, size_t *length) {
+  size_t line_length = strlen(line);
+  char *source = malloc(target + line_length);
+  size_t used = 0;
+  while (used < target) {
+    memcpy(source + used, line, line_length);
+    used += line_length;
+  }
+  *length = used;
+  return source;
+}
+
+static int matches_sequential(const char *source, size_t length,
+                              int threads) {
+  token_stream_t *stream = parallel_scanner_scan(source, length, threads);
+  scanner_t scanner;
+  scanner_init(&scanner, source, length);
+  int same = 1;
+  for (size_t i = 0; i < stream->count && same; i++) {
+    token_t expected = scanner_scan_token(&scanner);
+    token_t actual = stream->tokens[i];
+    same = expected.type == actual.type && expected.start == actual.start &&
+           expected.length == actual.length && expected.line == actual.line;
+  }
+  same &= stream->tokens[stream->count - 1].type == TOKEN_EOF;
+  token_stream_free(stream);
+  return same;
+}
+
+int main() {
+  tape_t *test = tape();
+
+  int testStatus = test->test("parallel scanner", ^(tape_t *t) {
+    t->clearState();
+
+    size_t length;
+    char *source = generate(1 << 20, "", &length);
+
+    const char *bounds[9];
+    size_t chunks = scanner_split(source, length, 8, bounds);
+    int boundsOk = chunks == 8 && bounds[0] == source &&
+                   bounds[chunks] == source + length;
+    for (size_t i = 1; i < chunks; i++) {
+      boundsOk &= bounds[i] > bounds[i - 1] && bounds[i][-1] == '\n';
+    }
+    t->ok("splits after newlines in order", boundsOk);
+
+    int streamsOk = 1;
+    for (int threads = 1; threads <= 8; threads++) {
+      streamsOk &= matches_sequential(source, length, threads);
+    }
+    t->ok("1 to 8 threads match the sequential scanner", streamsOk);
+    free(source);
+
+    source = generate(1 << 18, "print \"never closed\n\n\n", &length);
+    t->ok("an unterminated string at the end matches",
+          matches_sequential(source, length, 8));
+    free(source);
+
+    source = generate(1 << 18, "/* never closed\n\n\n", &length);
+    t->ok("an unterminated block comment at the end matches",
+          matches_sequential(source, length, 8));
+    free(source);
+
+    // Runs longer than a vector block cross every split point, so the
+    // kernels must not count newlines past the end of their chunk.
+    source = repeat("var x = 1;                                        "
+                    "\n\n\n\n",
+                    200000, &length);
+    t->ok("blank runs straddling the splits keep their line numbers",
+          matches_sequential(source, length, 8));
+    free(source);
+
+    char newlines[128];
+    memset(newlines, '\n', sizeof newlines - 1);
+    newlines[sizeof newlines - 1] = '\0';
+    memcpy(newlines, "x;  \t", 5);
+    source = repeat(newlines, 200000, &length);
+    int newlinesOk = 1;
+    for (int threads = 2; threads <= 8; threads++) {
+      newlinesOk &= matches_sequential(source, length, threads);
+    }
+    t->ok("newline runs straddling the splits keep their line numbers",
+          newlinesOk);
+    free(source);
+
+    const char *tiny = "print 1;\n";
+    t->ok("a source below the chunk size scans in one piece",
+          matches_sequential(tiny, strlen(tiny), 8));
+    t->ok("an empty source scans to EOF", matches_sequential("", 0, 8));
+  });
+
+  exit(testStatus);
+}
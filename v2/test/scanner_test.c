@@ -0,0 +1,189 @@
+#include <Block.h>
+#include <scanner.h>
+#include <stdio.h>
+#include <string.h>
+#include <tape/tape.h>
+
+typedef struct {
+  token_type_t type;
+  const char *lexeme;
+  int line;
+} expected_token_t;
+
+static int scans_as(const char *source, const expected_token_t *expected,
+                    size_t count) {
+  scanner_t scanner;
+  scanner_init(&scanner, source, strlen(source));
+  for (size_t i = 0; i < count; i++) {
+    token_t token = scanner_scan_token(&scanner);
+    if (token.type != expected[i].type ||
+        token.length != strlen(expected[i].lexeme) ||
+        memcmp(token.start, expected[i].lexeme, token.length) != 0 ||
+        token.line != expected[i].line) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static token_t nth_token(const char *source, int n) {
+  scanner_t scanner;
+  scanner_init(&scanner, source, strlen(source));
+  token_t token = scanner_scan_token(&scanner);
+  while (n-- > 0) {
+    token = scanner_scan_token(&scanner);
+  }
+  return token;
+}
+
+#define SCANS_AS(source, ...)                                                  \
+  scans_as(source, (expected_token_t[]){__VA_ARGS__},                          \
+           sizeof((expected_token_t[]){__VA_ARGS__}) /                         \
+               sizeof(expected_token_t))
+
+int main() {
+  tape_t *test = tape();
+
+  int testStatus = test->test("scanner", ^(tape_t *t) {
+    t->clearState();
+
+    t->ok("scans punctuation",
+          SCANS_AS("(){},.-+;*/", {TOKEN_LEFT_PAREN, "(", 1},
+                   {TOKEN_RIGHT_PAREN, ")", 1}, {TOKEN_LEFT_BRACE, "{", 1},
+                   {TOKEN_RIGHT_BRACE, "}", 1}, {TOKEN_COMMA, ",", 1},
+                   {TOKEN_DOT, ".", 1}, {TOKEN_MINUS, "-", 1},
+                   {TOKEN_PLUS, "+", 1}, {TOKEN_SEMICOLON, ";", 1},
+                   {TOKEN_STAR, "*", 1}, {TOKEN_SLASH, "/", 1},
+                   {TOKEN_EOF, "", 1}));
+
+    t->ok("scans one and two character operators",
+          SCANS_AS("! != = == > >= < <=", {TOKEN_BANG, "!", 1},
+                   {TOKEN_BANG_EQUAL, "!=", 1}, {TOKEN_EQUAL, "=", 1},
+                   {TOKEN_EQUAL_EQUAL, "==", 1}, {TOKEN_GREATER, ">", 1},
+                   {TOKEN_GREATER_EQUAL, ">=", 1}, {TOKEN_LESS, "<", 1},
+                   {TOKEN_LESS_EQUAL, "<=", 1}));
+
+    t->ok("scans every keyword",
+          SCANS_AS("and class else false for fun if nil or print return "
+                   "super this true var while",
+                   {TOKEN_AND, "and", 1}, {TOKEN_CLASS, "class", 1},
+                   {TOKEN_ELSE, "else", 1}, {TOKEN_FALSE, "false", 1},
+                   {TOKEN_FOR, "for", 1}, {TOKEN_FUN, "fun", 1},
+                   {TOKEN_IF, "if", 1}, {TOKEN_NIL, "nil", 1},
+                   {TOKEN_OR, "or", 1}, {TOKEN_PRINT, "print", 1},
+                   {TOKEN_RETURN, "return", 1}, {TOKEN_SUPER, "super", 1},
+                   {TOKEN_THIS, "this", 1}, {TOKEN_TRUE, "true", 1},
+                   {TOKEN_VAR, "var", 1}, {TOKEN_WHILE, "while", 1}));
+
+    t->ok("keyword prefixes and extensions are identifiers",
+          SCANS_AS("an classy f fo th t _or or2", {TOKEN_IDENTIFIER, "an", 1},
+                   {TOKEN_IDENTIFIER, "classy", 1},
+                   {TOKEN_IDENTIFIER, "f", 1}, {TOKEN_IDENTIFIER, "fo", 1},
+                   {TOKEN_IDENTIFIER, "th", 1}, {TOKEN_IDENTIFIER, "t", 1},
+                   {TOKEN_IDENTIFIER, "_or", 1},
+                   {TOKEN_IDENTIFIER, "or2", 1}));
+
+    t->ok("scans numbers",
+          SCANS_AS("12 3.25 4. .5", {TOKEN_NUMBER, "12", 1},
+                   {TOKEN_NUMBER, "3.25", 1}, {TOKEN_NUMBER, "4", 1},
+                   {TOKEN_DOT, ".", 1}, {TOKEN_DOT, ".", 1},
+                   {TOKEN_NUMBER, "5", 1}));
+
+    t->ok("strings keep their quotes and start line",
+          SCANS_AS("\"a\nb\" x", {TOKEN_STRING, "\"a\nb\"", 1},
+                   {TOKEN_IDENTIFIER, "x", 2}));
+
+    t->ok("skips comments and counts lines",
+          SCANS_AS("// line\nvar /* block\n comment */ x\n\t\r;",
+                   {TOKEN_VAR, "var", 2}, {TOKEN_IDENTIFIER, "x", 3},
+                   {TOKEN_SEMICOLON, ";", 4}, {TOKEN_EOF, "", 4}));
+
+    t->ok("a block comment ends at the first star slash",
+          SCANS_AS("/* a * b / c */ x", {TOKEN_IDENTIFIER, "x", 1}));
+
+    t->ok("block comments nest",
+          SCANS_AS("/* a /* b */ c */ x /*/**/*/ y",
+                   {TOKEN_IDENTIFIER, "x", 1}, {TOKEN_IDENTIFIER, "y", 1}));
+    t->ok("a star slash needs both bytes",
+          SCANS_AS("/*/ */ x /* **/ y", {TOKEN_IDENTIFIER, "x", 1},
+                   {TOKEN_IDENTIFIER, "y", 1}));
+    t->ok("reports an unterminated nested block comment",
+          SCANS_AS("/* a /* b */\n", {TOKEN_ERROR,
+                                       "Unterminated block comment.", 2},
+                   {TOKEN_EOF, "", 2}));
+    t->ok("reports a block comment cut off after its star",
+          SCANS_AS("/* a *", {TOKEN_ERROR, "Unterminated block comment.", 1}));
+
+    // Runs of every length around the 16 and 32 byte vector widths.
+    int blankOk = 1;
+    int stringOk = 1;
+    int commentOk = 1;
+    int identifierOk = 1;
+    char blank[128];
+    char literal[128];
+    char comment[128];
+    char word[128];
+    for (int n = 0; n < 100; n++) {
+      int newlines = 0;
+      for (int i = 0; i < n; i++) {
+        blank[i] = " \t\r\n"[i % 4];
+        literal[i + 1] = i % 5 == 4 ? '\n' : 'a';
+        comment[i + 2] = "*\n/\n"[i % 4];
+        word[i + 1] = "aZ_9"[i % 4];
+        newlines += i % 4 == 3;
+      }
+      sprintf(blank + n, "x");
+      literal[0] = '"';
+      sprintf(literal + n + 1, "\" y");
+      memcpy(comment, "/*", 2);
+      sprintf(comment + n + 2, " */ z");
+      word[0] = 'w';
+      sprintf(word + n + 1, ";");
+
+      token_t token = nth_token(blank, 0);
+      blankOk &= token.start == blank + n && token.line == 1 + newlines;
+
+      token = nth_token(literal, 0);
+      int stringLines = n / 5;
+      stringOk &= token.type == TOKEN_STRING && token.length == (size_t)n + 2;
+      stringOk &= nth_token(literal, 1).line == 1 + stringLines;
+
+      token = nth_token(comment, 0);
+      int commentLines = n / 2;
+      commentOk &= token.type == TOKEN_IDENTIFIER && token.start[0] == 'z' &&
+                   token.line == 1 + commentLines;
+
+      token = nth_token(word, 0);
+      identifierOk &= token.type == TOKEN_IDENTIFIER &&
+                      token.length == (size_t)n + 1;
+    }
+    t->ok("skips whitespace runs of every length", blankOk);
+    t->ok("scans string bodies of every length", stringOk);
+    t->ok("skips block comments of every length", commentOk);
+    t->ok("scans identifiers of every length", identifierOk);
+
+    t->ok("reports an unterminated string",
+          SCANS_AS("\"abc", {TOKEN_ERROR, "Unterminated string.", 1}));
+    t->ok("reports an unterminated block comment",
+          SCANS_AS("/* abc", {TOKEN_ERROR, "Unterminated block comment.", 1},
+                   {TOKEN_EOF, "", 1}));
+    t->ok("reports an unexpected character",
+          SCANS_AS("@x", {TOKEN_ERROR, "Unexpected character.", 1},
+                   {TOKEN_IDENTIFIER, "x", 1}));
+
+    t->ok("keeps returning EOF",
+          SCANS_AS("", {TOKEN_EOF, "", 1}, {TOKEN_EOF, "", 1}));
+
+    const char *source = "print x;";
+    scanner_t scanner;
+    scanner_init(&scanner, source, strlen(source));
+    scanner_scan_token(&scanner);
+    token_t token = scanner_scan_token(&scanner);
+
+    t->ok("tokens point into the source", token.start == source + 6);
+    t->ok("names token types",
+          strcmp(scanner_token_type_name(token.type), "IDENTIFIER") == 0);
+  });
+
+  exit(testStatus);
+}
@@ -0,0 +1,89 @@
+#include <Block.h>
+#include <errno.h>
+#include <source.h>
+#include <stdio.h>
+#include <string.h>
+#include <tape/tape.h>
+#include <unistd.h>
+
+static int padded(const source_t *source) {
+  for (size_t i = 0; i < SCANNER_PADDING; i++) {
+    if (source->text[source->length + i] != '\0') {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static source_t *open_with(const char *text, size_t length) {
+  char path[] = "/tmp/lox_source_test_XXXXXX";
+  int fd = mkstemp(path);
+  write(fd, text, length);
+  close(fd);
+  source_t *source = source_open(path);
+  unlink(path);
+  return source;
+}
+
+int main() {
+  tape_t *test = tape();
+
+  int testStatus = test->test("source", ^(tape_t *t) {
+    t->clearState();
+
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t sizes[] = {1, 100, page - 1, page, page + 1, 3 * page};
+    char *text = malloc(3 * page + 1);
+    for (size_t i = 0; i < 3 * page + 1; i++) {
+      text[i] = "var x = 1;\n"[i % 11];
+    }
+
+    int mappedOk = 1;
+    for (size_t i = 0; i < sizeof sizes / sizeof sizes[0]; i++) {
+      source_t *source = open_with(text, sizes[i]);
+      mappedOk &= source != NULL && source->mapped > 0 &&
+                  source->length == sizes[i] &&
+                  memcmp(source->text, text, sizes[i]) == 0 && padded(source);
+      source_free(source);
+    }
+    t->ok("maps files of every size with zero padding", mappedOk);
+
+    source_t *empty = open_with("", 0);
+    t->ok("reads an empty file", empty != NULL && empty->length == 0);
+    t->ok("pads an empty file", padded(empty));
+    source_free(empty);
+
+    int pipeFds[2];
+    pipe(pipeFds);
+    write(pipeFds[1], text, 1000);
+    close(pipeFds[1]);
+    source_t *piped = source_read_fd(pipeFds[0]);
+    close(pipeFds[0]);
+
+    t->ok("reads a pipe into a heap buffer", piped->mapped == 0);
+    t->ok("reads the whole pipe",
+          piped->length == 1000 && memcmp(piped->text, text, 1000) == 0);
+    t->ok("pads a pipe", padded(piped));
+    source_free(piped);
+
+    errno = 0;
+    t->ok("reports a missing file",
+          source_open("/tmp/lox_source_test_missing") == NULL &&
+              errno == ENOENT);
+
+    source_t *source = open_with(text, page);
+    scanner_t scanner;
+    scanner_init_padded(&scanner, source->text, source->length);
+    token_t token;
+    do {
+      token = scanner_scan_token(&scanner);
+    } while (token.type != TOKEN_EOF && token.type != TOKEN_ERROR);
+    t->ok("scans a padded source to the end",
+          token.type == TOKEN_EOF && token.start == source->text + page);
+    source_free(source);
+
+    free(text);
+  });
+
+  exit(testStatus);
+}
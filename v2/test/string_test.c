@@ -0,0 +1,636 @@
+#include <Block.h>
+#include <string/ascii.h>
+#include <string/search.h>
+#include <string/string.h>
+#include <tape/tape.h>
+
+static void randomBytes(char *buffer, size_t length) {
+  const char charset[] = "abcxyzABCXYZ@[`{ \t\n\v\f\r09";
+  for (size_t i = 0; i < length; i++) {
+    buffer[i] = charset[arc4random() % (sizeof charset - 1)];
+  }
+}
+
+// Whether stringParseDecimal and strtod agree on every bit of the value.
+static int parsesLikeStrtod(const char *str) {
+  double expected = strtod(str, NULL);
+  decimal_number_t parsed = stringParseDecimal(str, strlen(str));
+  return parsed.error == 0 &&
+         memcmp(&parsed.value, &expected, sizeof(double)) == 0;
+}
+
+// The obvious quadratic search, as a reference for the vector kernels.
+static const char *searchReference(const char *haystack, size_t n,
+                                   const char *needle, size_t m, int last) {
+  const char *found = NULL;
+  for (size_t i = 0; i + m <= n; i++) {
+    if (memcmp(haystack + i, needle, m) == 0) {
+      found = haystack + i;
+      if (!last) {
+        break;
+      }
+    }
+  }
+  return found;
+}
+
+// Writes the iterator's tokens to out separated by '|', so a whole split
+// can be compared as one string.
+static char *splitTokens(string_split_iterator_t iterator, char *out,
+                         size_t size) {
+  string_view_t token;
+  size_t used = 0;
+  out[0] = '\0';
+  while (stringSplitViewNext(&iterator, &token)) {
+    used += snprintf(out + used, size - used, "%s%.*s", used ? "|" : "",
+                     (int)token.length, token.start);
+  }
+  return out;
+}
+
+// Joins collection into a temporary file through stringCollectionJoinToFd
+// and reads the result back, or returns NULL if the join failed.
+static char *joinThroughFd(string_collection_t *collection, const char *delim) {
+  FILE *file = tmpfile();
+  if (stringCollectionJoinToFd(collection, delim, fileno(file)) != 0) {
+    fclose(file);
+    return NULL;
+  }
+  long length = ftell(file);
+  char *joined = malloc(length + 1);
+  rewind(file);
+  joined[fread(joined, 1, length, file)] = '\0';
+  fclose(file);
+  return joined;
+}
+
+int main() {
+  tape_t *test = tape();
+
+  int testStatus = test->test("string", ^(tape_t *t) {
+    t->clearState();
+
+    t->strEqual("upcase", stringUpcase(t->string("hello World 123")),
+                "HELLO WORLD 123");
+    t->strEqual("upcase past the vector width",
+                stringUpcase(t->string("the quick brown fox jumps over "
+                                       "the lazy dog @[`{")),
+                "THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG @[`{");
+
+    t->strEqual("downcase", stringDowncase(t->string("HELLO World 123")),
+                "hello world 123");
+    t->strEqual("downcase past the vector width",
+                stringDowncase(t->string("THE QUICK BROWN FOX JUMPS OVER "
+                                         "THE LAZY DOG @[`{")),
+                "the quick brown fox jumps over the lazy dog @[`{");
+
+    t->strEqual("capitalize", stringCapitalize(t->string("hELLO")), "Hello");
+    t->strEqual("capitalize empty", stringCapitalize(t->string("")), "");
+
+    t->strEqual("trim", stringTrim(t->string("  \t hello world \n ")),
+                "hello world");
+    t->strEqual("trim nothing", stringTrim(t->string("hello")), "hello");
+    t->strEqual("trim only whitespace", stringTrim(t->string(" \t\r\n ")),
+                "");
+    t->strEqual("trim empty", stringTrim(t->string("")), "");
+    t->strEqual("trim long",
+                stringTrim(t->string("                                    "
+                                     "long enough to live on the heap"
+                                     "                                    ")),
+                "long enough to live on the heap");
+
+    string_view_t view =
+        stringViewTrim((string_view_t){.start = "  padded  ", .length = 10});
+    t->ok("view trim moves the start", view.start[0] == 'p');
+    t->ok("view trim shortens the length", view.length == 6);
+
+    int caseOk = 1;
+    int spanOk = 1;
+    int trimOk = 1;
+    char input[200];
+    char simd[200];
+    char scalar[200];
+    for (int round = 0; round < 2000; round++) {
+      size_t length = arc4random() % sizeof input;
+      randomBytes(input, length);
+
+      memcpy(simd, input, length);
+      memcpy(scalar, input, length);
+      stringAsciiUpcase(simd, length);
+      stringAsciiUpcaseScalar(scalar, length);
+      caseOk &= memcmp(simd, scalar, length) == 0;
+
+      stringAsciiDowncase(simd, length);
+      stringAsciiDowncaseScalar(scalar, length);
+      caseOk &= memcmp(simd, scalar, length) == 0;
+
+      size_t leading = arc4random() % (length + 1);
+      memset(input, ' ', leading);
+      spanOk &= stringAsciiSpanSpace(input, length) ==
+                stringAsciiSpanSpaceScalar(input, length);
+
+      size_t trailing = arc4random() % (length + 1);
+      memset(input + length - trailing, '\t', trailing);
+      trimOk &= stringAsciiTrimEnd(input, length) ==
+                stringAsciiTrimEndScalar(input, length);
+    }
+    t->ok("simd case conversion matches the scalar reference", caseOk);
+    t->ok("simd leading whitespace matches the scalar reference", spanOk);
+    t->ok("simd trailing whitespace matches the scalar reference", trimOk);
+
+    const char *decimals[] = {
+        "0", "-0", "1", "0.1", "3.14159", "1e22", "1e23", "123456789e-22",
+        // Halfway between two doubles: ties round to even.
+        "9007199254740993", "9007199254740995",
+        "1.00000000000000011102230246251565404236316680908203125",
+        "4503599627370496.5", "4503599627370497.5",
+        // Subnormals and the edges of the normal range.
+        "4.9406564584124654e-324", "2.4703282292062328e-324", "1e-310",
+        "123456789012345678901e-330",
+        "2.2250738585072011e-308", "2.2250738585072014e-308",
+        "1.7976931348623157e308",
+        // 19 significant digits and more.
+        "1234567890123456789", "12345678901234567890",
+        "0.1000000000000000055511151231257827", "7.3177701707893310e15",
+        "18446744073709551615e-10", "9999999999999999999999999e-300",
+    };
+    int decimalsOk = 1;
+    for (size_t i = 0; i < sizeof decimals / sizeof decimals[0]; i++) {
+      decimalsOk &= parsesLikeStrtod(decimals[i]);
+    }
+    t->ok("decimal edge cases match strtod exactly", decimalsOk);
+
+    int roundTripOk = 1;
+    int digitsOk = 1;
+    char buffer[64];
+    for (int round = 0; round < 20000; round++) {
+      uint64_t bits = (uint64_t)arc4random() << 32 | arc4random();
+      double value;
+      memcpy(&value, &bits, sizeof value);
+      if (isfinite(value)) {
+        snprintf(buffer, sizeof buffer, "%.17g", value);
+        roundTripOk &= parsesLikeStrtod(buffer);
+      }
+
+      size_t digits = 1 + arc4random() % 25;
+      for (size_t i = 0; i < digits; i++) {
+        buffer[i] = '0' + arc4random() % 10;
+      }
+      snprintf(buffer + digits, sizeof buffer - digits, "e%d",
+               (int)(arc4random() % 580) - 300);
+      digitsOk &= parsesLikeStrtod(buffer);
+    }
+    t->ok("random doubles round-trip through 17 digits", roundTripOk);
+    t->ok("random normal values with up to 25 digits match strtod", digitsOk);
+
+    const char *max = "9223372036854775807";
+    integer_number_t integer = stringParseInteger(max, strlen(max));
+    t->ok("the largest integer parses",
+          integer.error == 0 && integer.value == LLONG_MAX);
+    const char *min = "-9223372036854775808";
+    integer = stringParseInteger(min, strlen(min));
+    t->ok("the smallest integer parses",
+          integer.error == 0 && integer.value == LLONG_MIN);
+    const char *pastMax = "9223372036854775808";
+    integer = stringParseInteger(pastMax, strlen(pastMax));
+    t->ok("one past the largest integer overflows",
+          integer.error == NUMBER_ERROR_OVERFLOW && integer.value == 0);
+    const char *pastMin = "-9223372036854775809";
+    integer = stringParseInteger(pastMin, strlen(pastMin));
+    t->ok("one past the smallest integer underflows",
+          integer.error == NUMBER_ERROR_UNDERFLOW && integer.value == 0);
+    const char *huge = "99999999999999999999999999";
+    integer = stringParseInteger(huge, strlen(huge));
+    t->ok("far past the largest integer overflows",
+          integer.error == NUMBER_ERROR_OVERFLOW);
+
+    t->ok("integers with whitespace and a sign parse",
+          stringToInt(t->string(" \t+42")).value == 42);
+    t->ok("an integer without digits is NUMBER_ERROR_NO_DIGITS",
+          stringToInt(t->string("-")).error == NUMBER_ERROR_NO_DIGITS);
+    t->ok("an empty integer is NUMBER_ERROR_NO_DIGITS",
+          stringToInt(t->string("")).error == NUMBER_ERROR_NO_DIGITS);
+    integer = stringToInt(t->string("12abc"));
+    t->ok("trailing input after an integer keeps the value",
+          integer.error == NUMBER_ERROR_ADDITIONAL_CHARACTERS &&
+              integer.value == 12);
+
+    t->ok("a decimal without digits is NUMBER_ERROR_NO_DIGITS",
+          stringToDecimal(t->string(".")).error == NUMBER_ERROR_NO_DIGITS);
+    t->ok("a word is NUMBER_ERROR_NO_DIGITS",
+          stringToDecimal(t->string("abc")).error == NUMBER_ERROR_NO_DIGITS);
+    t->ok("a decimal too large is NUMBER_ERROR_OVERFLOW",
+          stringToDecimal(t->string("1e999")).error == NUMBER_ERROR_OVERFLOW);
+    t->ok("a decimal too negative is NUMBER_ERROR_UNDERFLOW",
+          stringToDecimal(t->string("-1e999")).error ==
+              NUMBER_ERROR_UNDERFLOW);
+    t->ok("a decimal too small is NUMBER_ERROR_UNSPECIFIED",
+          stringToDecimal(t->string("1e-999")).error ==
+              NUMBER_ERROR_UNSPECIFIED);
+    decimal_number_t decimal = stringToDecimal(t->string("2.5x"));
+    t->ok("trailing input after a decimal keeps the value",
+          decimal.error == NUMBER_ERROR_ADDITIONAL_CHARACTERS &&
+              decimal.value == 2.5);
+    decimal = stringToDecimal(t->string("0x1p4"));
+    t->ok("hex floats parse", decimal.error == 0 && decimal.value == 16);
+
+    int messagesOk = stringErrorMessage(0) == NULL;
+    for (int error = NUMBER_ERROR_NO_DIGITS;
+         error < NUMBER_ERROR_ADDITIONAL_CHARACTERS; error++) {
+      messagesOk &= strncmp(stringErrorMessage(error), "invalid", 7) == 0;
+    }
+    messagesOk &=
+        strncmp(stringErrorMessage(NUMBER_ERROR_ADDITIONAL_CHARACTERS),
+                "valid", 5) == 0;
+    t->ok("every error code has a message", messagesOk);
+
+    t->ok("indexOf", stringIndexOf(t->string("hello world"), "o") == 4);
+    t->ok("lastIndexOf", stringLastIndexOf(t->string("hello world"), "o") == 7);
+    t->ok("indexOf a missing pattern",
+          stringIndexOf(t->string("hello world"), "xyz") == -1);
+    t->ok("lastIndexOf finds a match only at index 0",
+          stringLastIndexOf(t->string("needle in a haystack longer than "
+                                      "one vector block"),
+                            "needle") == 0);
+    t->ok("lastIndexOf finds index 0 of a short haystack",
+          stringLastIndexOf(t->string("ab"), "ab") == 0);
+    t->ok("indexOf in a haystack shorter than a vector",
+          stringIndexOf(t->string("short"), "rt") == 3);
+    t->ok("lastIndexOf in a haystack shorter than a vector",
+          stringLastIndexOf(t->string("shorts"), "s") == 5);
+    t->ok("indexOf a pattern longer than the haystack",
+          stringIndexOf(t->string("ab"), "abc") == -1);
+    t->ok("indexOf an empty pattern is 0",
+          stringIndexOf(t->string("abc"), "") == 0);
+    t->ok("lastIndexOf an empty pattern is the length",
+          stringLastIndexOf(t->string("abc"), "") == 3);
+    t->ok("contains", stringContains(t->string("hello world"), "lo w"));
+
+    int firstOk = 1;
+    int lastOk = 1;
+    for (int round = 0; round < 5000; round++) {
+      size_t n = arc4random() % 100;
+      size_t m = 1 + arc4random() % 40;
+      // An exactly sized buffer, so AddressSanitizer catches overreads.
+      char *haystack = malloc(n);
+      char needle[40];
+      for (size_t i = 0; i < n; i++) {
+        haystack[i] = "ab"[arc4random() % 2];
+      }
+      for (size_t i = 0; i < m; i++) {
+        needle[i] = "ab"[arc4random() % 2];
+      }
+      // Plant the needle across a 16- or 32-byte boundary.
+      size_t boundary = round % 2 ? 16 : 32;
+      if (m <= n && n > boundary) {
+        size_t at = boundary - 1 - arc4random() % (m < boundary ? m : boundary);
+        if (at + m <= n) {
+          memcpy(haystack + at, needle, m);
+        }
+      }
+      firstOk &= stringSearchFirst(haystack, n, needle, m) ==
+                 searchReference(haystack, n, needle, m, 0);
+      lastOk &= stringSearchLast(haystack, n, needle, m) ==
+                searchReference(haystack, n, needle, m, 1);
+      free(haystack);
+    }
+    t->ok("first match agrees with the reference across vector boundaries",
+          firstOk);
+    t->ok("last match agrees with the reference across vector boundaries",
+          lastOk);
+
+    t->strEqual("replaceAll with a longer replacement",
+                stringReplaceAll(t->string("a-b-c-d"), "-", "<=>"),
+                "a<=>b<=>c<=>d");
+    t->strEqual("replaceAll with a shorter replacement",
+                stringReplaceAll(t->string("one, two, three, four, five, "
+                                           "six, seven, eight"),
+                                 ", ", ","),
+                "one,two,three,four,five,six,seven,eight");
+    t->strEqual("replaceAll with an empty replacement",
+                stringReplaceAll(t->string("banana"), "an", ""), "ba");
+    t->strEqual("replaceAll matches without overlapping",
+                stringReplaceAll(t->string("aaaaa"), "aa", "b"), "bba");
+    t->strEqual("replaceAll of a match at both ends",
+                stringReplaceAll(t->string("xyabcxy"), "xy", "XYZ"),
+                "XYZabcXYZ");
+    t->strEqual("replaceAll without a match",
+                stringReplaceAll(t->string("hello"), "xyz", "!"), "hello");
+    t->strEqual("replaceAll of an empty pattern changes nothing",
+                stringReplaceAll(t->string("hello"), "", "!"), "hello");
+
+    string_t *inlined = t->string("twenty-three characters");
+    t->ok("a string of STRING_INLINE_CAPACITY bytes is stored inline",
+          inlined->size == STRING_INLINE_CAPACITY &&
+              inlined->value == inlined->inlineValue);
+    string_t *spilled = t->string("twenty-four characters!!");
+    t->ok("one byte more moves the characters to the heap",
+          spilled->size == STRING_INLINE_CAPACITY + 1 &&
+              spilled->value != spilled->inlineValue);
+    stringConcat(inlined, "!");
+    t->strEqual("concat past the inline capacity keeps the characters",
+                inlined, "twenty-three characters!");
+    t->ok("concat past the inline capacity moves them to the heap",
+          inlined->value != inlined->inlineValue);
+    stringReplaceAll(spilled, "characters", "chars");
+    t->strEqual("shrinking below the inline capacity keeps the characters",
+                spilled, "twenty-four chars!!");
+    t->ok("shrinking below the inline capacity moves them back inline",
+          spilled->value == spilled->inlineValue);
+
+    size_t internedBefore = stringInternCount();
+    string_t *interned = stringIntern("interned");
+    t->ok("equal strings intern to the same pointer",
+          stringIntern("interned") == interned);
+    t->ok("a span interns to the same pointer as the string",
+          stringInternWithLength("interned string", 8) == interned);
+    t->ok("different strings intern to different pointers",
+          stringIntern("interned!") != interned);
+    t->ok("interning counts distinct values",
+          stringInternCount() == internedBefore + 2);
+    t->ok("interned strings are marked",
+          (interned->flags & STRING_FLAG_INTERNED) != 0);
+    t->ok("interned strings compare by pointer",
+          !stringEquals(interned, stringIntern("interned!")) &&
+              stringEquals(interned, t->string("interned")));
+    stringFree(interned);
+    t->ok("stringFree leaves interned strings alone",
+          stringIntern("interned") == interned &&
+              stringEql(interned, "interned"));
+    string_t *longInterned =
+        stringIntern("an interned string too long to be stored inline");
+    t->ok("long strings intern to the same pointer",
+          stringIntern("an interned string too long to be stored inline") ==
+              longInterned);
+    stringInternFree();
+    t->ok("stringInternFree empties the set", stringInternCount() == 0);
+
+    arena_t *scratch = arena(1024);
+    string_t *scoped = stringInArena(scratch, "alpha,beta,gamma");
+    t->ok("arena strings remember their arena", scoped->arena == scratch);
+    string_collection_t *fields = stringSplit(scoped, ",");
+    t->ok("split results live in the string's arena",
+          fields->arena == scratch && fields->size == 3 &&
+              stringCollectionLast(fields)->arena == scratch);
+    stringConcat(scoped, ",delta,epsilon,zeta,eta,theta,iota,kappa");
+    t->strEqual("arena strings grow past the inline capacity", scoped,
+                "alpha,beta,gamma,delta,epsilon,zeta,eta,theta,iota,kappa");
+    string_t *joined = stringCollectionJoin(fields, "+");
+    t->strEqual("join results live in the collection's arena", joined,
+                "alpha+beta+gamma");
+    t->ok("join results remember the arena", joined->arena == scratch);
+    string_collection_t *pushed = stringCollectionInArena(scratch, 0, NULL);
+    for (int i = 0; i < 2000; i++) {
+      stringCollectionPush(pushed, stringInArena(scratch, "pushed"));
+    }
+    t->ok("arena collections grow without a cap", pushed->size == 2000);
+    stringFree(scoped);
+    stringCollectionFree(fields);
+    t->strEqual("stringFree leaves arena strings alone", scoped,
+                "alpha,beta,gamma,delta,epsilon,zeta,eta,theta,iota,kappa");
+    t->strEqual("stringCollectionFree leaves arena collections alone",
+                stringCollectionFirst(fields), "alpha");
+
+    arenaReset(scratch);
+    string_t *reused = stringInArena(scratch, "reused");
+    t->ok("arenaReset rewinds to the first block",
+          (void *)reused == (void *)scoped);
+    void *large = arenaAlloc(scratch, 4096);
+    t->ok("allocations larger than a block get a block of their own",
+          large != NULL && scratch->large != NULL);
+    memset(large, 'x', 4096);
+    arenaReset(scratch);
+    t->ok("arenaReset returns large blocks", scratch->large == NULL);
+    char *grown = arenaAlloc(scratch, 16);
+    t->ok("arenaRealloc grows the newest allocation in place",
+          arenaRealloc(scratch, grown, 16, 64) == grown);
+    t->ok("arena allocations are aligned",
+          (uintptr_t)arenaAlloc(scratch, 3) % sizeof(max_align_t) == 0 &&
+              (uintptr_t)arenaAlloc(scratch, 5) % sizeof(max_align_t) == 0);
+    arenaFree(scratch);
+
+    stringReclaim();
+    string_t *retiredString = string("retired but still printable");
+    string_collection_t *retiredFields = stringSplit(t->string("a b c"), " ");
+    stringRetire(retiredString);
+    stringCollectionRetire(retiredFields);
+    stringRetire(stringIntern("retired interned"));
+    t->strEqual("retired strings stay readable until reclaimed",
+                retiredString, "retired but still printable");
+    t->strEqual("retired collections stay readable until reclaimed",
+                stringCollectionLast(retiredFields), "c");
+    t->ok("reclaim releases everything retired", stringReclaim() == 3);
+    t->ok("reclaim with nothing retired releases nothing",
+          stringReclaim() == 0);
+    for (int i = 0; i < 1000; i++) {
+      stringRetire(string("a string retired in a loop"));
+    }
+    t->ok("reclaim releases values retired past the initial capacity",
+          stringReclaim() == 1000);
+    char tokens[128];
+    t->ok("split view yields each token",
+          strcmp(splitTokens(stringSplitView(t->string("a b c"), " "), tokens,
+                             sizeof tokens),
+                 "a|b|c") == 0);
+    t->ok("split view skips empty fields",
+          strcmp(splitTokens(stringSplitView(t->string("a,,b,,,c"), ","),
+                             tokens, sizeof tokens),
+                 "a|b|c") == 0);
+    t->ok("split view ignores leading and trailing delimiters",
+          strcmp(splitTokens(stringSplitView(t->string(",a,b,"), ","),
+                             tokens, sizeof tokens),
+                 "a|b") == 0);
+    t->ok("split view splits on any delimiter character",
+          strcmp(splitTokens(stringSplitView(t->string("k=v; x=y"), "=; "),
+                             tokens, sizeof tokens),
+                 "k|v|x|y") == 0);
+    t->ok("split view of only delimiters yields nothing",
+          strcmp(splitTokens(stringSplitView(t->string(",,,"), ","), tokens,
+                             sizeof tokens),
+                 "") == 0);
+    t->ok("split view of an empty string yields nothing",
+          strcmp(splitTokens(stringSplitView(t->string(""), ","), tokens,
+                             sizeof tokens),
+                 "") == 0);
+    t->ok("split view without delimiters yields the whole string",
+          strcmp(splitTokens(stringSplitView(t->string("whole"), ""), tokens,
+                             sizeof tokens),
+                 "whole") == 0);
+    t->ok("split view handles delimiters past ASCII",
+          strcmp(splitTokens(stringSplitView(t->string("a\xff" "b\x80" "c"),
+                                             "\xff\x80"),
+                             tokens, sizeof tokens),
+                 "a|b|c") == 0);
+
+    string_t *line = t->string("  GET /index.html HTTP/1.1\n");
+    string_split_iterator_t words = stringSplitView(line, " \n");
+    string_view_t word;
+    stringSplitViewNext(&words, &word);
+    t->ok("split view tokens point into the source",
+          word.start == line->value + 2 && stringViewEql(word, "GET"));
+    t->strEqual("split view leaves the source unchanged", line,
+                "  GET /index.html HTTP/1.1\n");
+    string_view_t requestTarget = {.start = line->value, .length = 12};
+    t->ok("view split walks part of a string",
+          strcmp(splitTokens(stringViewSplit(requestTarget, " "), tokens,
+                             sizeof tokens),
+                 "GET|/index") == 0);
+
+    string_collection_t *split = stringSplit(t->string(",a,,b,"), ",");
+    t->ok("split matches the iterator on empty and trailing fields",
+          split->size == 2 && stringEql(split->arr[0], "a") &&
+              stringEql(split->arr[1], "b"));
+    stringCollectionFree(split);
+
+    stringRegexCacheFree();
+    string_regex_t *cachedRegex = stringRegexCached("([a-z]+)=([0-9]+)");
+    t->ok("a cache miss compiles the pattern",
+          cachedRegex != NULL && cachedRegex->cached &&
+              stringRegexCacheCount() == 1);
+    t->ok("a cache hit returns the same handle",
+          stringRegexCached("([a-z]+)=([0-9]+)") == cachedRegex &&
+              stringRegexCacheCount() == 1);
+    string_collection_t *pairs =
+        stringMatchGroup(t->string("a=1, bc=23, def=456"), "([a-z]+)=([0-9]+)");
+    t->ok("stringMatchGroup hits the cache", stringRegexCacheCount() == 1);
+    t->ok("stringMatchGroup collects every group of every match",
+          pairs->size == 6 && stringEql(pairs->arr[0], "a") &&
+              stringEql(pairs->arr[1], "1") &&
+              stringEql(pairs->arr[2], "bc") &&
+              stringEql(pairs->arr[3], "23") &&
+              stringEql(pairs->arr[4], "def") &&
+              stringEql(pairs->arr[5], "456"));
+    stringCollectionFree(pairs);
+
+    char pattern[32];
+    for (int i = 0; i < STRING_REGEX_CACHE_SIZE - 1; i++) {
+      snprintf(pattern, sizeof pattern, "pattern%d", i);
+      stringRegexCached(pattern);
+    }
+    t->ok("the cache fills up",
+          stringRegexCacheCount() == STRING_REGEX_CACHE_SIZE);
+    // cachedRegex is now the least recently used; touching it moves it to
+    // the front, so the next miss evicts pattern0 instead.
+    t->ok("a hit on the oldest entry keeps its handle",
+          stringRegexCached("([a-z]+)=([0-9]+)") == cachedRegex);
+    string_regex_t *newest = stringRegexCached("pattern-new");
+    t->ok("a miss on a full cache evicts one entry",
+          stringRegexCacheCount() == STRING_REGEX_CACHE_SIZE);
+    t->ok("the recently used entry survives eviction",
+          stringRegexCached("([a-z]+)=([0-9]+)") == cachedRegex);
+    for (int i = 1; i < STRING_REGEX_CACHE_SIZE - 1; i++) {
+      snprintf(pattern, sizeof pattern, "pattern-more%d", i);
+      stringRegexCached(pattern);
+    }
+    t->ok("entries used since are kept",
+          stringRegexCached("([a-z]+)=([0-9]+)") == cachedRegex &&
+              stringRegexCached("pattern-new") == newest);
+    for (int i = 0; i < STRING_REGEX_CACHE_SIZE; i++) {
+      snprintf(pattern, sizeof pattern, "pattern-last%d", i);
+      stringRegexCached(pattern);
+    }
+    t->ok("the cache never grows past STRING_REGEX_CACHE_SIZE",
+          stringRegexCacheCount() == STRING_REGEX_CACHE_SIZE);
+    stringRegexCacheFree();
+    t->ok("freeing the cache empties it", stringRegexCacheCount() == 0);
+
+    string_regex_t *regex = stringRegex("([a-z]+)(-([0-9]+))?");
+    t->ok("a caller's handle is not cached",
+          regex != NULL && !regex->cached && regex->groups == 4);
+    string_collection_t *groups =
+        stringMatchGroupRegex(t->string("  ab-12 cd ef-3"), regex);
+    t->ok("groups come from each match's own offsets",
+          groups->size == 9 && stringEql(groups->arr[0], "ab") &&
+              stringEql(groups->arr[1], "-12") &&
+              stringEql(groups->arr[2], "12") &&
+              stringEql(groups->arr[3], "cd") &&
+              stringEql(groups->arr[6], "ef") &&
+              stringEql(groups->arr[8], "3"));
+    t->ok("groups that did not take part are empty",
+          groups->arr[4]->size == 0 && groups->arr[5]->size == 0);
+    stringCollectionFree(groups);
+    groups = stringMatchGroupRegex(t->string("xy"), regex);
+    t->ok("a handle can be reused on another string",
+          groups->size == 3 && stringEql(groups->arr[0], "xy"));
+    stringCollectionFree(groups);
+    stringRegexFree(regex);
+
+    regex = stringRegex("^(a)");
+    groups = stringMatchGroupRegex(t->string("aaa"), regex);
+    t->ok("later matches don't match the start of the string",
+          groups->size == 1);
+    stringCollectionFree(groups);
+    stringRegexFree(regex);
+
+    regex = stringRegex("(x*)");
+    groups = stringMatchGroupRegex(t->string("axxb"), regex);
+    t->ok("empty matches make progress",
+          groups->size >= 2 && stringCollectionIndexOf(groups, "xx") >= 0);
+    stringCollectionFree(groups);
+    stringRegexFree(regex);
+
+    string_collection_t *parts = stringSplit(t->string("one two three"), " ");
+    t->strEqual("join", stringCollectionJoin(parts, ", "),
+                "one, two, three");
+    t->strEqual("join without a delimiter", stringCollectionJoin(parts, ""),
+                "onetwothree");
+    string_collection_t *nothing = stringCollection(0, NULL);
+    t->strEqual("join of an empty collection",
+                stringCollectionJoin(nothing, ","), "");
+
+    char *streamed;
+    size_t streamedLength;
+    FILE *stream = open_memstream(&streamed, &streamedLength);
+    int streamResult = stringCollectionJoinToFile(parts, ", ", stream);
+    fclose(stream);
+    t->ok("join to a file writes the joined string",
+          streamResult == 0 && strcmp(streamed, "one, two, three") == 0);
+    free(streamed);
+    FILE *readOnly = fopen("/dev/null", "r");
+    t->ok("join to a file reports write errors",
+          stringCollectionJoinToFile(parts, ", ", readOnly) == -1);
+    fclose(readOnly);
+
+    char *written = joinThroughFd(parts, ", ");
+    t->ok("join to a file descriptor writes the joined string",
+          written != NULL && strcmp(written, "one, two, three") == 0);
+    free(written);
+    written = joinThroughFd(parts, "");
+    t->ok("join to a file descriptor without a delimiter",
+          written != NULL && strcmp(written, "onetwothree") == 0);
+    free(written);
+    written = joinThroughFd(nothing, ",");
+    t->ok("join to a file descriptor of an empty collection",
+          written != NULL && written[0] == '\0');
+    free(written);
+    t->ok("join to a file descriptor reports write errors",
+          stringCollectionJoinToFd(parts, ", ", -1) == -1);
+
+    // More elements than one writev call takes, so the iovecs are refilled
+    // with a delimiter pending between batches.
+    string_collection_t *many = stringCollection(0, NULL);
+    char element[16];
+    for (int i = 0; i < 5 * STRING_JOIN_IOV_COUNT + 3; i++) {
+      snprintf(element, sizeof element, "e%d", i);
+      stringCollectionPush(many, string(element));
+    }
+    string_t *expected = stringCollectionJoin(many, "--");
+    written = joinThroughFd(many, "--");
+    t->ok("join to a file descriptor spans several writev calls",
+          written != NULL && strcmp(written, expected->value) == 0);
+    free(written);
+    stream = open_memstream(&streamed, &streamedLength);
+    stringCollectionJoinToFile(many, "--", stream);
+    fclose(stream);
+    t->ok("join to a file matches join on a long collection",
+          strcmp(streamed, expected->value) == 0);
+    free(streamed);
+    stringFree(expected);
+    stringCollectionFree(many);
+    stringCollectionFree(nothing);
+    stringCollectionFree(parts);
+    stringInternFree();
+  });
+
+  exit(testStatus);
+}
@@ -0,0 +1,137 @@
+#include <Block.h>
+#include <object.h>
+#include <stdlib.h>
+#include <string.h>
+#include <table.h>
+#include <tape/tape.h>
+
+// Keys built by hand, so tests can choose colliding hashes.
+static obj_string_t *key(const char *chars, uint32_t hash) {
+  size_t length = strlen(chars);
+  obj_string_t *string = malloc(sizeof(obj_string_t) + length + 1);
+  string->obj.type = OBJ_STRING;
+  string->length = length;
+  string->hash = hash;
+  memcpy(string->chars, chars, length + 1);
+  return string;
+}
+
+static int has(table_t *table, obj_string_t *key, double expected) {
+  value_t value;
+  return table_get(table, key, &value) && value_is_number(value) &&
+         value_as_number(value) == expected;
+}
+
+int main() {
+  tape_t *test = tape();
+
+  int testStatus = test->test("table", ^(tape_t *t) {
+    t->clearState();
+
+    table_t table;
+    table_init(&table);
+    obj_string_t *a = key("a", 1);
+    obj_string_t *b = key("b", 2);
+    value_t value;
+    t->ok("empty table misses", !table_get(&table, a, &value));
+    t->ok("empty table deletes nothing", !table_delete(&table, a));
+    t->ok("first set is new", table_set(&table, a, value_number(1)));
+    t->ok("get finds it", has(&table, a, 1));
+    t->ok("other keys miss", !table_get(&table, b, &value));
+    t->ok("overwrite is not new", !table_set(&table, a, value_number(2)));
+    t->ok("overwrite replaces the value", has(&table, a, 2));
+    t->ok("delete removes", table_delete(&table, a));
+    t->ok("deleted keys miss", !table_get(&table, a, &value));
+    t->ok("deleting twice fails", !table_delete(&table, a));
+    table_free(&table);
+
+    // Three keys in one probe sequence; deleting the middle one must not
+    // cut off the last.
+    table_init(&table);
+    obj_string_t *first = key("first", 7);
+    obj_string_t *middle = key("middle", 7);
+    obj_string_t *last = key("last", 7 + 8);
+    table_set(&table, first, value_number(1));
+    table_set(&table, middle, value_number(2));
+    table_set(&table, last, value_number(3));
+    table_delete(&table, middle);
+    t->ok("probes run past tombstones", has(&table, last, 3));
+    t->ok("find_string runs past tombstones",
+          table_find_string(&table, "last", 4, 7 + 8) == last);
+    t->ok("find_string compares content",
+          table_find_string(&table, "lasT", 4, 7 + 8) == NULL);
+    size_t count = table.count;
+    t->ok("reinsertion reuses the tombstone",
+          table_set(&table, middle, value_number(4)) && table.count == count);
+    t->ok("reinserted key is found", has(&table, middle, 4));
+    table_free(&table);
+
+    enum { KEY_COUNT = 10000 };
+    obj_string_t **keys = malloc(KEY_COUNT * sizeof(obj_string_t *));
+    for (int i = 0; i < KEY_COUNT; i++) {
+      char chars[16];
+      snprintf(chars, sizeof chars, "key%d", i);
+      // A weak hash, so long collision runs form.
+      keys[i] = key(chars, (uint32_t)(i / 4));
+    }
+    table_init(&table);
+    int ok = 1;
+    for (int i = 0; i < KEY_COUNT; i++) {
+      ok &= table_set(&table, keys[i], value_number(i));
+    }
+    t->ok("growth keeps every key new", ok);
+    t->ok("growth stays under the load factor",
+          table.count * 100 <= table.capacity * TABLE_MAX_LOAD);
+    for (int i = 0; i < KEY_COUNT; i += 2) {
+      ok &= table_delete(&table, keys[i]);
+    }
+    for (int i = 0; i < KEY_COUNT; i++) {
+      ok &= i % 2 == 0 ? !table_get(&table, keys[i], &value)
+                       : has(&table, keys[i], i);
+    }
+    t->ok("half deleted, the rest found", ok);
+
+    // Churn: insertions reuse or sweep tombstones instead of filling up.
+    for (int round = 0; round < 20; round++) {
+      for (int i = 0; i < KEY_COUNT; i += 2) {
+        table_set(&table, keys[i], value_number(round));
+      }
+      for (int i = 0; i < KEY_COUNT; i += 2) {
+        ok &= table_delete(&table, keys[i]);
+      }
+    }
+    t->ok("churn keeps lookups working", ok && has(&table, keys[1], 1));
+    t->ok("churn does not grow without bound", table.capacity <= 2 * 16384);
+
+    table_t copy;
+    table_init(&copy);
+    table_add_all(&table, &copy);
+    ok = copy.count == KEY_COUNT / 2;
+    for (int i = 1; i < KEY_COUNT; i += 2) {
+      ok &= has(&copy, keys[i], i);
+    }
+    t->ok("add_all copies live entries only", ok);
+    table_free(&copy);
+    table_free(&table);
+
+    table_init(&table);
+    table.max_load = 50;
+    for (int i = 0; i < 100; i++) {
+      table_set(&table, keys[i], value_number(i));
+    }
+    t->ok("max_load is tunable", table.capacity == 256);
+    table_free(&table);
+
+    for (int i = 0; i < KEY_COUNT; i++) {
+      free(keys[i]);
+    }
+    free(keys);
+    free(a);
+    free(b);
+    free(first);
+    free(middle);
+    free(last);
+  });
+
+  exit(testStatus);
+}
@@ -0,0 +1,92 @@
+#include <Block.h>
+#include <tape/tape.h>
+#include <unrolled_list.h>
+
+int main() {
+  tape_t *test = tape();
+
+  int testStatus = test->test("unrolled list", ^(tape_t *t) {
+    t->clearState();
+
+    unrolled_list_t *list = unrolled_list_new();
+
+    t->ok("list is not null", list != NULL);
+    t->ok("list is empty", list->size == 0);
+    t->ok("list head is null", list->head == NULL);
+    t->ok("list tail is null", list->tail == NULL);
+
+    long values[100];
+    for (long i = 0; i < 100; i++) {
+      values[i] = i;
+    }
+
+    for (long i = 50; i < 100; i++) {
+      unrolled_list_insert_end(list, &values[i]);
+    }
+    for (long i = 49; i >= 0; i--) {
+      unrolled_list_insert_beginning(list, &values[i]);
+    }
+
+    t->ok("list has 100 elements", list->size == 100);
+    t->ok("list spans several nodes", list->head != list->tail);
+
+    long expected = 0;
+    int inOrder = 1;
+    for (unrolled_list_iterator_t it = unrolled_list_begin(list);
+         unrolled_list_iterator_valid(it); unrolled_list_iterator_next(&it)) {
+      inOrder &= *(long *)unrolled_list_iterator_get(it) == expected++;
+    }
+    t->ok("iteration visits elements in order", inOrder && expected == 100);
+
+    unrolled_list_iterator_t it = unrolled_list_begin(list);
+    while (unrolled_list_iterator_valid(it)) {
+      if (*(long *)unrolled_list_iterator_get(it) % 2 == 0) {
+        unrolled_list_remove(list, &it);
+      } else {
+        unrolled_list_iterator_next(&it);
+      }
+    }
+
+    t->ok("list has 50 elements after removing evens", list->size == 50);
+    expected = 1;
+    int oddsInOrder = 1;
+    for (it = unrolled_list_begin(list); unrolled_list_iterator_valid(it);
+         unrolled_list_iterator_next(&it)) {
+      oddsInOrder &= *(long *)unrolled_list_iterator_get(it) == expected;
+      expected += 2;
+    }
+    t->ok("remaining elements are the odds in order", oddsInOrder);
+
+    unrolled_list_t *other = unrolled_list_new();
+    void *bulk[30];
+    for (int i = 0; i < 30; i++) {
+      bulk[i] = &values[i];
+    }
+    unrolled_list_append(other, bulk, 30);
+
+    t->ok("bulk append adds 30 elements", other->size == 30);
+
+    unrolled_list_node_t *otherTail = other->tail;
+    unrolled_list_splice(list, other);
+
+    t->ok("splice moves the elements", list->size == 80);
+    t->ok("splice empties the other list", other->size == 0);
+    t->ok("splice links the other tail", list->tail == otherTail);
+    t->ok("last element is the last appended",
+          *(long *)list->tail->data[list->tail->count - 1] == 29);
+
+    it = unrolled_list_begin(list);
+    while (unrolled_list_iterator_valid(it)) {
+      unrolled_list_remove(list, &it);
+    }
+
+    t->ok("list is empty after removing everything", list->size == 0);
+    t->ok("list head is null again", list->head == NULL);
+    t->ok("list tail is null again", list->tail == NULL);
+
+    unrolled_list_free(other);
+    unrolled_list_free(list);
+  });
+
+  exit(testStatus);
+}
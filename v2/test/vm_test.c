@@ -0,0 +1,281 @@
+#include <Block.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <compiler.h>
+#include <tape/tape.h>
+#include <vm.h>
+
+typedef struct run_t {
+  interpret_result_t result;
+  char *out;
+  char *err;
+} run_t;
+
+static run_t run(const char *source) {
+  run_t run;
+  size_t out_length;
+  size_t err_length;
+  vm_t *vm = vm_new();
+  vm->out = open_memstream(&run.out, &out_length);
+  vm->err = open_memstream(&run.err, &err_length);
+  scanner_t scanner;
+  scanner_init(&scanner, source, strlen(source));
+  run.result = vm_interpret(vm, &scanner);
+  fclose(vm->out);
+  fclose(vm->err);
+  vm_free(vm);
+  return run;
+}
+
+static void run_free(run_t run) {
+  free(run.out);
+  free(run.err);
+}
+
+// Runs source and checks it succeeded and printed exactly expected.
+static int prints(const char *source, const char *expected) {
+  run_t result = run(source);
+  int ok = result.result == INTERPRET_OK && strcmp(result.out, expected) == 0;
+  if (!ok) {
+    fprintf(stderr, "got \"%s\"%s", result.out, result.err);
+  }
+  run_free(result);
+  return ok;
+}
+
+// Runs source and checks it failed with expected, reporting message.
+static int fails(const char *source, interpret_result_t expected,
+                 const char *message) {
+  run_t result = run(source);
+  int ok = result.result == expected && strstr(result.err, message) != NULL;
+  if (!ok) {
+    fprintf(stderr, "got %d \"%s\"\n", result.result, result.err);
+  }
+  run_free(result);
+  return ok;
+}
+
+// Compiles source and checks the script's bytecode is exactly expected.
+static int compiles_to(const char *source, const uint8_t *expected,
+                       size_t length) {
+  vm_t *vm = vm_new();
+  scanner_t scanner;
+  scanner_init(&scanner, source, strlen(source));
+  obj_function_t *function = compiler_compile(vm, &scanner);
+  int ok = function != NULL && function->chunk.count == length &&
+           memcmp(function->chunk.code, expected, length) == 0;
+  vm_free(vm);
+  return ok;
+}
+
+int main() {
+  tape_t *test = tape();
+
+  int testStatus = test->test("vm", ^(tape_t *t) {
+    t->clearState();
+
+    t->ok("arithmetic follows precedence",
+          prints("print 1 + 2 * 3 - 4 / 2;", "5\n"));
+    t->ok("grouping", prints("print (1 + 2) * 3;", "9\n"));
+    t->ok("unary", prints("print -(3 - 5); print !nil; print !0;",
+                          "2\ntrue\nfalse\n"));
+    t->ok("comparison", prints("print 1 < 2; print 2 <= 1; print 3 >= 3;"
+                               "print 1 == 1; print 1 != 1;",
+                               "true\nfalse\ntrue\ntrue\nfalse\n"));
+    t->ok("fractions", prints("print 2.5 * 2; print 1 / 4;", "5\n0.25\n"));
+    t->ok("nan is unequal to itself",
+          prints("var n = 0 / 0; print n == n; print n != n; print -0 == 0;",
+                 "false\ntrue\ntrue\n"));
+    t->ok("values of different types are unequal",
+          prints("print nil == false; print 0 == false; print \"\" == nil;",
+                 "false\nfalse\nfalse\n"));
+    t->ok("literals", prints("print nil; print true; print false;",
+                             "nil\ntrue\nfalse\n"));
+
+    t->ok("string concatenation",
+          prints("print \"foo\" + \"bar\";", "foobar\n"));
+    t->ok("strings are interned",
+          prints("print \"ab\" == \"a\" + \"b\";", "true\n"));
+    t->ok("strings and numbers differ", prints("print \"1\" == 1;", "false\n"));
+
+    t->ok("globals", prints("var a = 1; var b; a = a + 2; print a; print b;",
+                            "3\nnil\n"));
+    t->ok("locals shadow globals",
+          prints("var a = \"global\"; { var a = \"local\"; print a; } print a;",
+                 "local\nglobal\n"));
+    t->ok("assignment is an expression",
+          prints("var a; var b; a = b = 4; print a + b;", "8\n"));
+
+    t->ok("if else", prints("if (1 > 2) print \"a\"; else print \"b\";",
+                            "b\n"));
+    t->ok("logical operators short circuit",
+          prints("print nil or \"x\"; print false and undefined;"
+                 "print 1 and 2;",
+                 "x\nfalse\n2\n"));
+    t->ok("while", prints("var i = 0; while (i < 3) { print i; i = i + 1; }",
+                          "0\n1\n2\n"));
+    t->ok("for", prints("var sum = 0; for (var i = 1; i <= 100; i = i + 1) "
+                        "sum = sum + i; print sum;",
+                        "5050\n"));
+
+    t->ok("functions and recursion",
+          prints("fun fib(n) { if (n < 2) return n; "
+                 "return fib(n - 2) + fib(n - 1); } print fib(20);",
+                 "6765\n"));
+    t->ok("functions print by name",
+          prints("fun f() {} print f; print clock;", "<fn f>\n<native fn>\n"));
+    t->ok("implicit return is nil", prints("fun f() {} print f();", "nil\n"));
+    t->ok("natives", prints("print clock() >= 0;", "true\n"));
+
+    t->ok("closures capture variables",
+          prints("fun counter() { var n = 0; fun inc() { n = n + 1; "
+                 "return n; } return inc; } var c = counter(); c(); c(); "
+                 "print c(); var d = counter(); print d();",
+                 "3\n1\n"));
+    t->ok("closures share a captured variable",
+          prints("var get; var set; { var x = 1; fun g() { return x; } "
+                 "fun s(v) { x = v; } get = g; set = s; } set(7); print get();",
+                 "7\n"));
+    t->ok("closures capture each loop scope",
+          prints("var fs; { var i = 1; fun f() { return i; } fs = f; i = 2; } "
+                 "print fs();",
+                 "2\n"));
+    t->ok("nested closures",
+          prints("fun a() { var x = \"x\"; fun b() { fun c() { return x; } "
+                 "return c; } return b; } print a()()();",
+                 "x\n"));
+
+    t->ok("classes and fields",
+          prints("class P {} var p = P(); p.x = 1; p.y = p.x + 1; print p.y; "
+                 "print P; print p;",
+                 "2\nP\nP instance\n"));
+    t->ok("initializers and methods",
+          prints("class Point { init(x, y) { this.x = x; this.y = y; } "
+                 "sum() { return this.x + this.y; } } "
+                 "print Point(3, 4).sum();",
+                 "7\n"));
+    t->ok("bound methods remember this",
+          prints("class A { init() { this.v = \"a\"; } "
+                 "get() { return this.v; } } var m = A().get; print m();",
+                 "a\n"));
+    t->ok("fields shadow methods",
+          prints("class A { f() { return 1; } } fun g() { return 2; } "
+                 "var a = A(); a.f = g; print a.f();",
+                 "2\n"));
+    t->ok("inheritance and super",
+          prints("class A { hi() { return \"A\"; } name() { return \"a\"; } }"
+                 " class B < A { hi() { return \"B\" + super.hi(); } } "
+                 "var b = B(); print b.hi(); print b.name(); "
+                 "var h = b.hi; print h();",
+                 "BA\na\nBA\n"));
+    t->ok("init returns this",
+          prints("class A { init() { this.x = 1; } } var a = A(); "
+                 "print a.init() == a;",
+                 "true\n"));
+
+    t->ok("local adds fuse",
+          compiles_to("{ var a = 1; var b = 2; print a + b; }",
+                      (uint8_t[]){OP_CONSTANT, 0, 0, OP_CONSTANT, 0, 1,
+                                  OP_ADD_LOCALS, 1, 2, OP_PRINT, OP_POP,
+                                  OP_POP, OP_NIL, OP_RETURN},
+                      14));
+    t->ok("constant adds fuse",
+          compiles_to("print nil + 1;",
+                      (uint8_t[]){OP_NIL, OP_ADD_CONSTANT, 0, 0, OP_PRINT,
+                                  OP_NIL, OP_RETURN},
+                      7));
+    t->ok("comparisons fuse with the branch",
+          compiles_to("if (1 <= 2) print nil;",
+                      (uint8_t[]){OP_CONSTANT, 0, 0, OP_CONSTANT, 0, 1,
+                                  OP_JUMP_IF_GREATER, 0, 5, OP_NIL, OP_PRINT,
+                                  OP_JUMP, 0, 0, OP_NIL, OP_RETURN},
+                      16));
+    t->ok("nothing fuses across a jump target",
+          compiles_to("if (nil and 1 < 2) print nil;",
+                      (uint8_t[]){OP_NIL, OP_JUMP_IF_FALSE, 0, 8, OP_POP,
+                                  OP_CONSTANT, 0, 0, OP_CONSTANT, 0, 1,
+                                  OP_LESS, OP_JUMP_IF_FALSE, 0, 6, OP_POP,
+                                  OP_NIL, OP_PRINT, OP_JUMP, 0, 1, OP_POP,
+                                  OP_NIL, OP_RETURN},
+                      24));
+
+    t->ok("fused adds keep their slow paths",
+          prints("{ var a = \"a\"; var b = \"b\"; print a + b; "
+                 "print a + \"c\"; print 1 + 2 + 3; }",
+                 "ab\nac\n6\n"));
+    t->ok("fused comparisons branch both ways",
+          prints("for (var i = 0; i < 6; i = i + 1) { if (i == 1) print \"eq\";"
+                 " if (i != 2) {} else print \"ne\"; if (i > 3) print i; "
+                 "if (i >= 5) print \"ge\"; if (i <= 0) print \"le\"; }",
+                 "le\neq\nne\n4\n5\nge\n"));
+    t->ok("fused branches inside logical operators",
+          prints("var n = 0; while (n < 3 and !(n == 2)) n = n + 1; print n;",
+                 "2\n"));
+    t->ok("fused add errors",
+          fails("{ var a = 1; var b = nil; print a + b; }",
+                INTERPRET_RUNTIME_ERROR,
+                "Operands must be two numbers or two strings."));
+    t->ok("fused comparison errors",
+          fails("if (\"a\" < 1) print nil;", INTERPRET_RUNTIME_ERROR,
+                "Operands must be numbers."));
+
+    t->ok("compile errors name the token",
+          fails("var = 1;", INTERPRET_COMPILE_ERROR,
+                "[line 1] Error at '=': Expect variable name."));
+    t->ok("compile errors at end",
+          fails("print 1", INTERPRET_COMPILE_ERROR,
+                "[line 1] Error at end: Expect ';' after value."));
+    t->ok("scanner errors are compile errors",
+          fails("print \"open;", INTERPRET_COMPILE_ERROR,
+                "Error: Unterminated string."));
+    t->ok("invalid assignment target",
+          fails("1 + 2 = 3;", INTERPRET_COMPILE_ERROR,
+                "Invalid assignment target."));
+    t->ok("return at top level",
+          fails("return 1;", INTERPRET_COMPILE_ERROR,
+                "Can't return from top-level code."));
+    t->ok("this outside a class",
+          fails("print this;", INTERPRET_COMPILE_ERROR,
+                "Can't use 'this' outside of a class."));
+    t->ok("reading a local in its own initializer",
+          fails("{ var a = a; }", INTERPRET_COMPILE_ERROR,
+                "Can't read local variable in its own initializer."));
+
+    t->ok("type errors",
+          fails("print -\"a\";", INTERPRET_RUNTIME_ERROR,
+                "Operand must be a number.\n[line 1] in script\n"));
+    t->ok("mixed addition",
+          fails("print 1 + \"a\";", INTERPRET_RUNTIME_ERROR,
+                "Operands must be two numbers or two strings."));
+    t->ok("undefined globals",
+          fails("\n\nprint missing;", INTERPRET_RUNTIME_ERROR,
+                "Undefined variable 'missing'.\n[line 3] in script\n"));
+    t->ok("assignment does not declare",
+          fails("missing = 1;", INTERPRET_RUNTIME_ERROR,
+                "Undefined variable 'missing'."));
+    t->ok("arity is checked",
+          fails("fun f(a) {} f(1, 2);", INTERPRET_RUNTIME_ERROR,
+                "Expected 1 arguments but got 2."));
+    t->ok("runtime errors print a stack trace",
+          fails("fun inner() { return nil + 1; }\nfun outer() { inner(); }\n"
+                "outer();",
+                INTERPRET_RUNTIME_ERROR,
+                "[line 1] in inner()\n[line 2] in outer()\n"
+                "[line 3] in script\n"));
+    t->ok("deep recursion overflows",
+          fails("fun f() { f(); } f();", INTERPRET_RUNTIME_ERROR,
+                "Stack overflow."));
+    t->ok("calling a non-function",
+          fails("var a = 1; a();", INTERPRET_RUNTIME_ERROR,
+                "Can only call functions and classes."));
+    t->ok("undefined properties",
+          fails("class A {} A().missing;", INTERPRET_RUNTIME_ERROR,
+                "Undefined property 'missing'."));
+    t->ok("inheriting from a non-class",
+          fails("var A = 1; class B < A {}", INTERPRET_RUNTIME_ERROR,
+                "Superclass must be a class."));
+  });
+
+  exit(testStatus);
+}